@@ -0,0 +1,61 @@
+#include "arena.h"
+
+#include <stdint.h>
+
+
+namespace Math_solver {
+
+	void* NodeArena::allocate(size_t size, size_t alignment)
+	{
+		size_t padding = (alignment - ((uintptr_t)current_ & (alignment - 1))) & (alignment - 1);
+
+		if (current_ == nullptr || padding + size > remaining_)
+		{
+			size_t new_block_size = (size > block_size_) ? size : block_size_;
+
+			current_ = static_cast<char*>(::operator new(new_block_size));
+			remaining_ = new_block_size;
+			padding = 0;
+
+			blocks_.push_back({ current_, new_block_size });
+		}
+
+		void* result = current_ + padding;
+
+		current_ += padding + size;
+		remaining_ -= padding + size;
+		num_bytes_ += size;
+
+		return result;
+	}
+
+	void NodeArena::reset()
+	{
+		if (blocks_.empty())
+			return;
+
+		for (size_t i = 1; i < blocks_.size(); i++)
+			::operator delete(blocks_[i].data);
+
+		blocks_.resize(1);
+		nodes_.clear();
+
+		current_ = blocks_[0].data;
+		remaining_ = blocks_[0].size;
+		num_bytes_ = 0;
+	}
+
+	void NodeArena::release()
+	{
+		for (const block_t& block : blocks_)
+			::operator delete(block.data);
+
+		blocks_.clear();
+		nodes_.clear();
+
+		current_ = nullptr;
+		remaining_ = 0;
+		num_bytes_ = 0;
+	}
+
+}
\ No newline at end of file
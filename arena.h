@@ -0,0 +1,77 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace Math_solver {
+
+	class BaseNode;
+
+	// Bump allocator for expression nodes. Nodes are placed one after another
+	// into large blocks and all of them are released at once - destructors are
+	// never called, so only trivially destructible types can be created here.
+	// Expression nodes are also listed as they are created, for metrics.
+	class NodeArena
+	{
+	private:
+		struct block_t
+		{
+			char* data;
+			size_t size;
+		};
+
+		std::vector<block_t> blocks_;
+		char* current_;
+		size_t remaining_;
+		size_t block_size_;
+		size_t num_bytes_;
+
+		std::vector<const BaseNode*> nodes_; // created since clear_nodes(), folded ones too
+
+	public:
+		NodeArena(size_t block_size = 4096)
+			: current_(nullptr), remaining_(0), block_size_(block_size), num_bytes_(0)
+		{
+		}
+
+		NodeArena(const NodeArena&) = delete;
+		NodeArena& operator=(const NodeArena&) = delete;
+
+		~NodeArena()
+		{
+			release();
+		}
+
+		template<typename T, typename... Args>
+		T* create(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+			static_assert(alignof(T) <= alignof(std::max_align_t), "Unsupported alignment");
+
+			T* object = new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+			if constexpr (std::is_base_of<BaseNode, T>::value)
+				nodes_.push_back(object);
+
+			return object;
+		}
+
+		void* allocate(size_t size, size_t alignment);
+
+		void reset();   // rewind, keep the first block for reuse
+		void release(); // free all blocks
+
+		size_t get_num_bytes() const { return num_bytes_; }
+
+		const std::vector<const BaseNode*>& get_nodes() const { return nodes_; }
+		void clear_nodes() { nodes_.clear(); }
+	};
+
+}
+
+#endif // !ARENA_H
@@ -0,0 +1,331 @@
+// Benchmark suite - measures every stage separately over the expressions in
+// bench/corpus (lexing, compilation, evaluation, result formatting), then
+// every built-in function (Do_func), the element-wise kernels and
+// Format_number. Prints ns/op, allocations/op and throughput of each
+// benchmark as JSON.
+//
+// Build (from the repository root):
+//   bench/create_bench.sh
+// Run:
+//   bench/math_bench [corpus directory] [minimum seconds per benchmark]
+
+#include "parser.h"
+#include "operations.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// every allocation of the process is counted
+static size_t num_allocations = 0;
+
+void* operator new(size_t size)
+{
+	num_allocations++;
+
+	void* memory = malloc(size != 0 ? size : 1);
+
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+typedef struct result {
+	std::string name;
+	std::string input;
+	size_t num_ops;
+	double ns_per_op;
+	double allocations_per_op;
+	double ops_per_second;
+	double bytes_per_second; // 0 if the benchmark has no text input
+} result_t;
+
+static double min_seconds = 0.2;
+static volatile double sink; // keeps results alive
+
+// repeats "run" (doing "ops_per_run" operations on "bytes_per_run" bytes) for at least min_seconds
+template<typename F>
+static result_t Measure(const std::string& name, const std::string& input, size_t ops_per_run, size_t bytes_per_run, F run)
+{
+	run(); // warm up
+
+	size_t num_runs = 0;
+	size_t allocations = num_allocations;
+	auto start = std::chrono::steady_clock::now();
+	double seconds;
+
+	do {
+		run();
+		num_runs++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (seconds < min_seconds);
+
+	double num_ops = (double)num_runs * ops_per_run;
+
+	result_t result;
+	result.name = name;
+	result.input = input;
+	result.num_ops = (size_t)num_ops;
+	result.ns_per_op = seconds * 1e9 / num_ops;
+	result.allocations_per_op = (double)(num_allocations - allocations) / num_ops;
+	result.ops_per_second = num_ops / seconds;
+	result.bytes_per_second = (double)bytes_per_run * num_runs / seconds;
+
+	return result;
+}
+
+static std::vector<std::string> Read_lines(const std::string& path)
+{
+	std::ifstream file(path);
+	std::vector<std::string> lines;
+	std::string line;
+
+	if (!file)
+	{
+		fprintf(stderr, "Can't open corpus file: %s\n", path.c_str());
+		exit(1);
+	}
+
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (!line.empty())
+			lines.push_back(line);
+	}
+
+	return lines;
+}
+
+static void Measure_corpus(const std::string& directory, const std::string& name, std::vector<result_t>& results)
+{
+	std::vector<std::string> lines = Read_lines(directory + "/" + name + ".txt");
+	Math_solver::Context context(1);
+
+	size_t num_bytes = 0;
+
+	for (const std::string& line : lines)
+		num_bytes += line.size();
+
+	// defines variables of scripts, later statements refer to them
+	std::vector<Math_solver::CompiledExpression> expressions;
+	std::vector<Math_solver::value_t> values;
+
+	for (const std::string& line : lines)
+	{
+		Math_solver::Parser parser(line.data(), line.size(), context);
+		expressions.push_back(parser.Compile());
+		values.push_back(expressions.back().evaluate());
+	}
+
+	results.push_back(Measure("lex", name, lines.size(), num_bytes, [&] {
+		for (const std::string& line : lines)
+		{
+			Math_solver::Parser parser(line.data(), line.size(), context);
+			sink = parser.Lex();
+		}
+	}));
+
+	// parsing, constant folding and lowering to a program
+	results.push_back(Measure("compile", name, lines.size(), num_bytes, [&] {
+		for (const std::string& line : lines)
+		{
+			Math_solver::Parser parser(line.data(), line.size(), context);
+			sink = parser.Compile().get_num_parameters();
+		}
+	}));
+
+	results.push_back(Measure("evaluate", name, lines.size(), 0, [&] {
+		for (const Math_solver::CompiledExpression& expression : expressions)
+			sink = expression.evaluate().vec.to_scalar();
+	}));
+
+	results.push_back(Measure("format", name, values.size(), 0, [&] {
+		char text[Math_solver::VALUE_STR_SIZE];
+
+		for (const Math_solver::value_t& value : values)
+			sink = (double)(value.is_mat() ? value.mat.to_chars(text, PRECISION) : value.vec.to_chars(text, PRECISION));
+	}));
+}
+
+static void Measure_functions(std::vector<result_t>& results)
+{
+	using Math_solver::value_t;
+
+	const value_t none;
+	const value_t half(0.5);
+	const value_t ten(10.0);
+	const value_t vector3(glm::dvec4(1.0, 2.0, 3.0, 0.0), 3);
+	const value_t other3(glm::dvec4(-2.0, 0.5, 4.0, 0.0), 3);
+	const value_t matrix4(glm::dmat4(1.0), 4);
+
+	typedef struct function_case {
+		Math_solver::TokenType function;
+		const char* name;
+		const value_t* parameters[4];
+	} function_case_t;
+
+	const function_case_t cases[] =
+	{
+		{ Math_solver::RAD_FN, "RAD", { &half, &none, &none, &none } },
+		{ Math_solver::DEG_FN, "DEG", { &half, &none, &none, &none } },
+		{ Math_solver::SIN_FN, "sin", { &half, &none, &none, &none } },
+		{ Math_solver::COS_FN, "cos", { &half, &none, &none, &none } },
+		{ Math_solver::TAN_FN, "tan", { &half, &none, &none, &none } },
+		{ Math_solver::SINH_FN, "sinh", { &half, &none, &none, &none } },
+		{ Math_solver::COSH_FN, "cosh", { &half, &none, &none, &none } },
+		{ Math_solver::TANH_FN, "tanh", { &half, &none, &none, &none } },
+		{ Math_solver::ASIN_FN, "asin", { &half, &none, &none, &none } },
+		{ Math_solver::ACOS_FN, "acos", { &half, &none, &none, &none } },
+		{ Math_solver::ATAN_FN, "atan", { &half, &none, &none, &none } },
+		{ Math_solver::ABS_FN, "abs", { &half, &none, &none, &none } },
+		{ Math_solver::LN_FN, "ln", { &half, &none, &none, &none } },
+		{ Math_solver::LOG_FN, "log", { &half, &none, &none, &none } },
+		{ Math_solver::EXP_FN, "exp", { &half, &none, &none, &none } },
+		{ Math_solver::SQRT_FN, "sqrt", { &half, &none, &none, &none } },
+		{ Math_solver::SIN_FN, "sin(vec3)", { &vector3, &none, &none, &none } },
+		{ Math_solver::VEC3_FN, "vec3", { &half, &half, &half, &none } },
+		{ Math_solver::VEC4_FN, "vec4", { &half, &half, &half, &half } },
+		{ Math_solver::LENGTH_FN, "length", { &vector3, &none, &none, &none } },
+		{ Math_solver::NORMALIZE_FN, "normalize", { &vector3, &none, &none, &none } },
+		{ Math_solver::DOT_PRODUCT_FN, "dot", { &vector3, &other3, &none, &none } },
+		{ Math_solver::CROSS_PRODUCT_FN, "cross", { &vector3, &other3, &none, &none } },
+		{ Math_solver::MIX_FN, "mix", { &vector3, &other3, &half, &none } },
+		{ Math_solver::MAT3_FN, "mat3", { &matrix4, &none, &none, &none } },
+		{ Math_solver::MAT4_FN, "mat4", { &matrix4, &none, &none, &none } },
+		{ Math_solver::SCALE_FN, "scale", { &matrix4, &vector3, &none, &none } },
+		{ Math_solver::ROTATE_FN, "rotate", { &matrix4, &half, &vector3, &none } },
+		{ Math_solver::TRANSLATE_FN, "translate", { &matrix4, &vector3, &none, &none } },
+		{ Math_solver::INVERSE_TRANSPOSE_FN, "invtranspose", { &matrix4, &none, &none, &none } },
+		{ Math_solver::PERSPECTIVE_PROJ_FN, "perspective", { &half, &ten, &half, &ten } },
+		{ Math_solver::ORTHO_PROJ_FN, "ortho", { &half, &ten, &half, &ten } },
+		{ Math_solver::RAND_FN, "rand", { &ten, &none, &none, &none } },
+		{ Math_solver::FACTORIAL, "factorial", { &ten, &none, &none, &none } }
+	};
+
+	Math_solver::RandomStream rng(1, 0);
+	const size_t NUM_CALLS = 1000;
+
+	for (const function_case_t& c : cases)
+	{
+		results.push_back(Measure("Do_func", c.name, NUM_CALLS, 0, [&] {
+			for (size_t i = 0; i < NUM_CALLS; i++)
+				sink = Math_solver::Do_func(c.function, *c.parameters[0], *c.parameters[1], *c.parameters[2], *c.parameters[3], &rng).vec.to_scalar();
+		}));
+	}
+}
+
+// element-wise kernels of every instruction set through their table, and the
+// inlined single block vectors use instead; each call feeds the next one
+static void Measure_element_kernels(std::vector<result_t>& results)
+{
+	const size_t NUM_CALLS = 1000;
+	const double factor = 1.0000001;
+
+	alignas(32) double data[16];
+
+	for (Math_solver::InstructionSet set : { Math_solver::SIMD_SCALAR, Math_solver::SIMD_SSE2, Math_solver::SIMD_AVX })
+	{
+		if (!Math_solver::Simd_is_supported(set))
+			continue;
+
+		static const char* NAMES[Math_solver::NUM_INSTRUCTION_SETS] = { "scalar", "sse2", "avx" };
+		Math_solver::vector_scalar_kernel_t kernel = Math_solver::Simd_vector_scalar_kernel(Math_solver::ELEMENT_MULTIPLY, set);
+
+		for (unsigned int num_blocks : { 1u, 4u })
+		{
+			std::fill(data, data + 16, 1.0);
+
+			results.push_back(Measure("element_kernel", std::string(num_blocks == 1 ? "vec4/" : "mat4/") + NAMES[set], NUM_CALLS, 0, [&] {
+				for (size_t i = 0; i < NUM_CALLS; i++)
+					kernel(data, factor, data, num_blocks, 4);
+
+				sink = data[0];
+			}));
+		}
+	}
+
+	std::fill(data, data + 16, 1.0);
+
+	results.push_back(Measure("element_kernel", "vec4/inline", NUM_CALLS, 0, [&] {
+		for (size_t i = 0; i < NUM_CALLS; i++)
+			Math_solver::Simd_block_vector_scalar<Math_solver::ELEMENT_MULTIPLY>(data, factor, data, 4);
+
+		sink = data[0];
+	}));
+}
+
+static void Measure_format_number(std::vector<result_t>& results)
+{
+	std::vector<double> numbers(4096);
+	uint64_t state = 88172645463325252ull;
+
+	for (double& number : numbers) // xorshift, spread over magnitudes
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		number = (double)(int64_t)(state >> 11) / Math_solver::POWERS_OF_10[state % 16];
+	}
+
+	results.push_back(Measure("Format_number", "mixed", numbers.size(), 0, [&] {
+		char text[Math_solver::NUMBER_STR_SIZE];
+
+		for (double number : numbers)
+			sink = (double)Math_solver::Format_number(number, PRECISION, text);
+	}));
+}
+
+static void Print_json(const std::vector<result_t>& results)
+{
+	printf("{\n  \"benchmarks\": [\n");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const result_t& r = results[i];
+
+		printf("    { \"name\": \"%s\", \"input\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.2f, \"allocations_per_op\": %.2f, \"ops_per_second\": %.0f, \"bytes_per_second\": %.0f }%s\n",
+			r.name.c_str(), r.input.c_str(), r.num_ops, r.ns_per_op, r.allocations_per_op, r.ops_per_second, r.bytes_per_second, (i + 1 < results.size()) ? "," : "");
+	}
+
+	printf("  ]\n}\n");
+}
+
+int main(int argc, char* argv[])
+{
+	std::string directory = (argc > 1) ? argv[1] : "bench/corpus";
+
+	if (argc > 2)
+		min_seconds = atof(argv[2]);
+
+	std::vector<result_t> results;
+
+	for (const char* corpus : { "scalar", "vector", "matrix", "script" })
+		Measure_corpus(directory, corpus, results);
+
+	Measure_functions(results);
+	Measure_element_kernels(results);
+	Measure_format_number(results);
+
+	Print_json(results);
+	return 0;
+}
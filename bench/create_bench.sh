@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# Builds the benchmarks, run from the repository root with GLM in ./glm
+# (as cloned by create_solver.sh):
+#
+#   bench/create_bench.sh && bench/math_bench > bench.json
+#   bench/scaling_bench > scaling.json
+
+SOURCES=$(ls *.cpp | grep -v main.cpp)
+
+g++ -O2 -Wall -DNDEBUG -I./glm -I. bench/bench.cpp $SOURCES -pthread -o bench/math_bench || exit 1
+g++ -O2 -Wall -DNDEBUG -I./glm -I. bench/lexer.cpp $SOURCES -pthread -o bench/lexer_bench || exit 1
+g++ -O2 -Wall -DNDEBUG -I./glm -I. bench/scaling.cpp $SOURCES -pthread -o bench/scaling_bench || exit 1
+
+echo "Done!"
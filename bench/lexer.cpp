@@ -0,0 +1,56 @@
+// Lexer throughput benchmark - parses a long expression made almost only of
+// numeric literals (as in data scripts) and reports bytes and literals per second.
+//
+// Build (from the repository root):
+//   bench/create_bench.sh
+
+#include "parser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+
+static std::string Make_numeric_expression(unsigned int num_literals)
+{
+	static const char* literals[] = { "3.14159", "42", "0.000125", "1000000.5", "7", "0x1F", "0b1011", "0o755", ".5", "2718.28" };
+
+	std::string expression;
+
+	for (unsigned int i = 0; i < num_literals; i++)
+	{
+		if (i != 0)
+			expression += (i % 2) ? " + " : " - ";
+
+		expression += literals[i % (sizeof(literals) / sizeof(literals[0]))];
+	}
+
+	return expression;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int num_literals = (argc > 1) ? (unsigned int)atoi(argv[1]) : 10000;
+	unsigned int num_iterations = (argc > 2) ? (unsigned int)atoi(argv[2]) : 200;
+
+	std::string expression = Make_numeric_expression(num_literals);
+	Math_solver::Parser parser(expression);
+
+	parser.Compile(); // warm up
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 0; i < num_iterations; i++)
+		parser.Compile();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double num_bytes = (double)expression.size() * num_iterations;
+
+	printf("literals: %u, bytes: %u, iterations: %u\n", num_literals, (unsigned int)expression.size(), num_iterations);
+	printf("%.1f MB/s, %.1f M literals/s, %.1f ns/literal\n",
+		num_bytes / seconds / 1e6,
+		(double)num_literals * num_iterations / seconds / 1e6,
+		seconds * 1e9 / ((double)num_literals * num_iterations));
+
+	return 0;
+}
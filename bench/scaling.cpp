@@ -0,0 +1,307 @@
+// Scaling benchmark - sweeps the shape of the input (expression length,
+// nesting depth, number of variables, length of assignment chains) in
+// doubling steps and records time and peak RSS of every point. Each point
+// runs in its own process, so a point which crashes (stack overflow) or
+// runs out of time is recorded and ends its curve instead of the benchmark.
+//
+// "exponent" of a point is the slope of log(time) over log(size) from the
+// previous point - 1 is linear, anything clearly above it is super-linear.
+//
+// Build (from the repository root, POSIX only):
+//   bench/create_bench.sh
+// Run:
+//   bench/scaling_bench [seconds per point] [maximum exponent]
+// With a maximum exponent the exit status is 1 if time grows faster than
+// that between any two sizes four times apart (from 10 ms per run).
+
+#include "parser.h"
+#include "script.h"
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+typedef struct point {
+	size_t size;
+	const char* status; // "ok", "error" (rejected input), "crashed" or "timeout"
+	double seconds;     // per run
+	double ns_per_unit;
+	long peak_rss_kib;
+	double exponent;    // 0 for the first point of a curve
+} point_t;
+
+typedef struct curve {
+	const char* dimension;
+	const char* unit;
+	std::vector<point_t> points;
+} curve_t;
+
+static double seconds_per_point = 10.0;
+static volatile double sink; // keeps results alive
+
+// "x + 1 * x - 2 / x + ..." - flat, variable operands so nothing is folded
+static std::string Generate_length(size_t size)
+{
+	static const char OPERATORS[] = { '+', '*', '-', '/' };
+	std::string text = "x";
+
+	for (size_t i = 1; i < size; i++)
+	{
+		text += ' ';
+		text += OPERATORS[i % 4];
+		text += ' ';
+		text += (i % 2) ? std::to_string(i % 97 + 1) : "x";
+	}
+
+	return text;
+}
+
+// "x + (x + (x + ...))"
+static std::string Generate_depth(size_t size)
+{
+	std::string text;
+
+	for (size_t i = 1; i < size; i++)
+		text += "x + (";
+
+	text += 'x';
+	text.append(size - 1, ')');
+
+	return text;
+}
+
+// "v0 = 0" ... "vN = N", then every variable is read once
+static std::string Generate_variables(size_t size)
+{
+	std::string text;
+
+	for (size_t i = 0; i < size; i++)
+		text += "v" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+
+	for (size_t i = 0; i < size; i++)
+		text += "v" + std::to_string(i) + " * 2\n";
+
+	return text;
+}
+
+// "a0 = 1", "a1 = a0 + 1", ... every assignment depends on the previous one
+static std::string Generate_chain(size_t size)
+{
+	std::string text = "a0 = 1\n";
+
+	for (size_t i = 1; i < size; i++)
+		text += "a" + std::to_string(i) + " = a" + std::to_string(i - 1) + " + 1\n";
+
+	text += "a" + std::to_string(size - 1) + "\n";
+
+	return text;
+}
+
+static void Run_expression(const std::string& text)
+{
+	Math_solver::Context context(1);
+	context.get_variables().set("x", Math_solver::value_t(0.5));
+
+	Math_solver::Parser parser(text.data(), text.size(), context);
+	sink = parser.Compile().evaluate().vec.to_scalar();
+}
+
+static void Run_script_text(const std::string& text)
+{
+	static FILE* null_output = fopen("/dev/null", "w");
+
+	Math_solver::Context context(1);
+
+	if (!Math_solver::Run_script(text.data(), text.size(), context, null_output, Math_solver::OUTPUT_TEXT))
+		throw std::runtime_error("script failed");
+}
+
+// runs in the forked child: repeats the point for a tenth of a second at least,
+// reports seconds per run (negative if the input was rejected) through "pipe_fd"
+static void Measure_point(const curve_t& curve, size_t size, int pipe_fd)
+{
+	std::string dimension = curve.dimension;
+	std::string text;
+	bool is_script = false;
+
+	if (dimension == "length")
+		text = Generate_length(size);
+	else if (dimension == "depth")
+		text = Generate_depth(size);
+	else if (dimension == "variables")
+	{
+		text = Generate_variables(size);
+		is_script = true;
+	}
+	else
+	{
+		text = Generate_chain(size);
+		is_script = true;
+	}
+
+	double seconds = -1.0;
+
+	try
+	{
+		size_t num_runs = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		do {
+			is_script ? Run_script_text(text) : Run_expression(text);
+			num_runs++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < 0.1);
+
+		seconds /= num_runs;
+	}
+	catch (const std::exception&)
+	{
+		seconds = -1.0;
+	}
+
+	if (write(pipe_fd, &seconds, sizeof(seconds)) != sizeof(seconds))
+		_exit(2);
+}
+
+static point_t Run_point(const curve_t& curve, size_t size)
+{
+	point_t point = { size, "crashed", 0.0, 0.0, 0, 0.0 };
+	int fds[2];
+
+	if (pipe(fds) != 0)
+	{
+		perror("pipe");
+		exit(1);
+	}
+
+	fflush(stdout);
+	pid_t child = fork();
+
+	if (child < 0)
+	{
+		perror("fork");
+		exit(1);
+	}
+
+	if (child == 0)
+	{
+		close(fds[0]);
+		alarm((unsigned int)ceil(seconds_per_point));
+		Measure_point(curve, size, fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+
+	double seconds = 0.0;
+	bool has_result = (read(fds[0], &seconds, sizeof(seconds)) == sizeof(seconds));
+	close(fds[0]);
+
+	int status = 0;
+	struct rusage usage;
+	wait4(child, &status, 0, &usage);
+
+	point.peak_rss_kib = usage.ru_maxrss;
+
+	if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM)
+		point.status = "timeout";
+	else if (has_result && seconds < 0.0)
+		point.status = "error";
+	else if (has_result && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+	{
+		point.status = "ok";
+		point.seconds = seconds;
+		point.ns_per_unit = seconds * 1e9 / size;
+	}
+
+	return point;
+}
+
+static void Print_json(const std::vector<curve_t>& curves)
+{
+	printf("{\n  \"curves\": [\n");
+
+	for (size_t i = 0; i < curves.size(); i++)
+	{
+		const curve_t& c = curves[i];
+
+		printf("    { \"dimension\": \"%s\", \"unit\": \"%s\", \"points\": [\n", c.dimension, c.unit);
+
+		for (size_t j = 0; j < c.points.size(); j++)
+		{
+			const point_t& p = c.points[j];
+
+			printf("      { \"size\": %zu, \"status\": \"%s\", \"seconds\": %.9f, \"ns_per_unit\": %.2f, \"peak_rss_kib\": %ld, \"exponent\": %.2f }%s\n",
+				p.size, p.status, p.seconds, p.ns_per_unit, p.peak_rss_kib, p.exponent, (j + 1 < c.points.size()) ? "," : "");
+		}
+
+		printf("    ] }%s\n", (i + 1 < curves.size()) ? "," : "");
+	}
+
+	printf("  ]\n}\n");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+		seconds_per_point = atof(argv[1]);
+
+	double max_exponent = (argc > 2) ? atof(argv[2]) : 0.0;
+	bool is_too_steep = false;
+
+	std::vector<curve_t> curves =
+	{
+		{ "length", "terms", {} },
+		{ "depth", "levels", {} },
+		{ "variables", "variables", {} },
+		{ "chain", "assignments", {} }
+	};
+
+	const size_t MIN_SIZE = 16;
+	const size_t MAX_SIZE = (size_t)1 << 20;
+
+	for (curve_t& curve : curves)
+	{
+		for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+		{
+			point_t point = Run_point(curve, size);
+
+			if (!curve.points.empty() && curve.points.back().seconds > 0.0 && point.seconds > 0.0)
+			{
+				const point_t& previous = curve.points.back();
+				point.exponent = log(point.seconds / previous.seconds) / log((double)point.size / previous.size);
+			}
+
+			// checked over two doublings, single steps are too noisy
+			if (max_exponent > 0.0 && curve.points.size() >= 2 && point.seconds >= 1e-2)
+			{
+				const point_t& start = curve.points[curve.points.size() - 2];
+				double exponent = log(point.seconds / start.seconds) / log((double)point.size / start.size);
+
+				if (exponent > max_exponent)
+				{
+					fprintf(stderr, "%s: %zu to %zu %s grow with exponent %.2f\n", curve.dimension, start.size, point.size, curve.unit, exponent);
+					is_too_steep = true;
+				}
+			}
+
+			curve.points.push_back(point);
+
+			if (point.status[0] != 'o') // curve ends at the first failing point
+				break;
+		}
+	}
+
+	Print_json(curves);
+	return is_too_steep ? 1 : 0;
+}
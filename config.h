@@ -1,9 +1,13 @@
-#ifndef CONFIG_H
-#define CONFIG_H
-
-#define VERBOSE				false
-#define FORMAT_RESULT		true
-#define PRECISION			6
-
-#endif // !CONFIG_H
-
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define VERBOSE				false
+#define FORMAT_RESULT		true
+#define PRECISION			6
+#define BATCH_CHUNK_ROWS	256
+#define USE_JIT				true
+#define MAX_NESTING_DEPTH	1000
+#define MAX_TREE_HEIGHT		10000
+
+#endif // !CONFIG_H
+
@@ -1,8 +1,12 @@
-#ifndef CONSTANTS_H
-#define CONSTANTS_H
-
-#define M_PI				3.14159265358979323846
-#define M_E					2.71828182845904523536
-#define RANDOM_MAX			1000
-
+#ifndef CONSTANTS_H
+#define CONSTANTS_H
+
+#ifndef M_PI
+#define M_PI				3.14159265358979323846
+#endif
+#ifndef M_E
+#define M_E					2.71828182845904523536
+#endif
+#define RANDOM_MAX			1000
+
 #endif // !CONSTANTS_H
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "context.h"
+
+
+namespace Math_solver {
+
+	Context& Get_default_context()
+	{
+		thread_local Context context;
+
+		return context;
+	}
+
+}
@@ -0,0 +1,72 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <cstdint>
+#include <random>
+
+#include "symbols.h"
+#include "random.h"
+#include "metrics.h"
+
+
+namespace Math_solver {
+
+	// Mutable evaluation state - user variables and random generator. Built-in
+	// functions and constants are immutable tables shared by all contexts, so
+	// parsers using different contexts can run on different threads without
+	// any locking. One context must not be used by two threads at once.
+	//
+	// Single evaluations draw from stream 0 of the seed, every batch gets
+	// a new stream and each of its rows is keyed by the row index, so batch
+	// results don't depend on the number of threads.
+	class Context
+	{
+	private:
+		SymbolTable variables_;
+
+		uint64_t seed_;
+		uint32_t num_streams_;
+		RandomStream rng_;
+
+		Metrics metrics_;
+
+	public:
+		Context()
+		{
+			std::random_device device;
+
+			seed(((uint64_t)device() << 32) | device());
+		}
+
+		explicit Context(uint64_t seed_value)
+		{
+			seed(seed_value);
+		}
+
+		// compiled programs refer to variable slots of their context
+		Context(const Context&) = delete;
+		Context& operator=(const Context&) = delete;
+
+		// restarts all streams
+		void seed(uint64_t seed_value)
+		{
+			seed_ = seed_value;
+			num_streams_ = 1;
+			rng_ = RandomStream(seed_, 0);
+		}
+
+		uint32_t new_stream() { return num_streams_++; }
+
+		SymbolTable& get_variables() { return variables_; }
+		RandomStream& get_rng() { return rng_; }
+		Metrics& get_metrics() { return metrics_; }
+		const Metrics& get_metrics() const { return metrics_; }
+		uint64_t get_seed() const { return seed_; }
+	};
+
+	// context of parsers constructed without one, separate for every thread
+	Context& Get_default_context();
+
+}
+
+#endif // !CONTEXT_H
@@ -29,7 +29,7 @@ echo "Done!"
 sleep 2
 echo "Compiling.."
 
-g++ -Wall -DNDEBUG -I./glm config.h constants.h error.h error.cpp functions.h functions.cpp operations.h operations.cpp types.h types.cpp parser.h parser.cpp main.cpp -o math_solver &> /dev/null
+g++ -Wall -DNDEBUG -I./glm config.h constants.h error.h error.cpp functions.h functions.cpp operations.h operations.cpp types.h types.cpp simd.h simd.cpp scheduler.h scheduler.cpp symbols.h symbols.cpp context.h context.cpp random.h random.cpp jit.h jit.cpp metrics.h metrics.cpp arena.h arena.cpp program.h program.cpp parser.h parser.cpp expression.h expression.cpp static_expression.h script.h script.cpp output.h output.cpp main.cpp -pthread -o math_solver &> /dev/null
 
 echo "Done!"
 sleep 2
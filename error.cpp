@@ -1,67 +1,67 @@
-#include "error.h"
-#include "config.h"
-
-#include <stdexcept>
-#include <stdio.h>
-
-
-namespace Math_solver {
-
-	void Print_info(const char* fmt, ...)
-	{
-		va_list va;
-		char text[255];
-
-		if (VERBOSE && fmt != nullptr)
-		{
-			va_start(va, fmt);
-			vsprintf(text, fmt, va);
-			va_end(va);
-
-			// print info
-			printf("%s\n", text);
-		}
-
-	}
-
-	void Print_warning(const char* file, int line, const char* func, const char* fmt, ...)
-	{
-		va_list va;
-		char formated_text[255];
-
-		if (fmt == nullptr)
-			return;
-
-		va_start(va, fmt);
-		vsprintf(formated_text, fmt, va);
-		va_end(va);
-
-		// add debug info
-		char output_text[300];
-		sprintf(output_text, "Warning: \"%s\" (line: %d) function: \'%s\' -> %s", file, line, func, formated_text);
-
-		// print warning
-		printf("%s\n", output_text);
-	}
-
-	void Throw_error(const char* file, int line, const char* func, const char* fmt, ...)
-	{
-		va_list va;
-		char formated_text[255];
-
-		if (fmt == nullptr)
-			return;
-
-		va_start(va, fmt);
-		vsprintf(formated_text, fmt, va);
-		va_end(va);
-
-		// add debug info
-		char output_text[300];
-		sprintf(output_text, "Error: \"%s\" (line: %d) function: \'%s\' -> %s", file, line, func, formated_text);
-
-		// throw exception
-		throw std::runtime_error(output_text);
-	}
-
+#include "error.h"
+#include "config.h"
+
+#include <stdexcept>
+#include <stdio.h>
+
+
+namespace Math_solver {
+
+	void Print_info(const char* fmt, ...)
+	{
+		va_list va;
+		char text[255];
+
+		if (VERBOSE && fmt != nullptr)
+		{
+			va_start(va, fmt);
+			vsnprintf(text, sizeof(text), fmt, va);
+			va_end(va);
+
+			// print info
+			printf("%s\n", text);
+		}
+
+	}
+
+	void Print_warning(const char* file, int line, const char* func, const char* fmt, ...)
+	{
+		va_list va;
+		char formated_text[255];
+
+		if (fmt == nullptr)
+			return;
+
+		va_start(va, fmt);
+		vsnprintf(formated_text, sizeof(formated_text), fmt, va);
+		va_end(va);
+
+		// add debug info
+		char output_text[300];
+		snprintf(output_text, sizeof(output_text), "Warning: \"%s\" (line: %d) function: \'%s\' -> %s", file, line, func, formated_text);
+
+		// print warning
+		printf("%s\n", output_text);
+	}
+
+	void Throw_error(const char* file, int line, const char* func, const char* fmt, ...)
+	{
+		va_list va;
+		char formated_text[255];
+
+		if (fmt == nullptr)
+			return;
+
+		va_start(va, fmt);
+		vsnprintf(formated_text, sizeof(formated_text), fmt, va);
+		va_end(va);
+
+		// add debug info
+		char output_text[300];
+		snprintf(output_text, sizeof(output_text), "Error: \"%s\" (line: %d) function: \'%s\' -> %s", file, line, func, formated_text);
+
+		// throw exception
+		throw std::runtime_error(output_text);
+	}
+
 }
\ No newline at end of file
@@ -1,19 +1,27 @@
-#ifndef ERROR_H
-#define ERROR_H
-
-#include <stdarg.h>
-
-
-namespace Math_solver {
-
-	void Print_info(const char* fmt, ...);
-	void Print_warning(const char* file, int line, const char* func, const char* fmt, ...);
-	void Throw_error(const char* file, int line, const char* func, const char* fmt, ...);
-
-}
-
-//#define INFO(par, ...) Print_info(par, ##__VA_ARGS__)
-//#define WARNING(par, ...) Print_warning(par, ##__VA_ARGS__)
-//#define ERROR(par, ...) Throw_error(par, ##__VA_ARGS__)
-
-#endif // !ERROR_H
+#ifndef ERROR_H
+#define ERROR_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+
+namespace Math_solver {
+
+	void Print_info(const char* fmt, ...);
+	void Print_warning(const char* file, int line, const char* func, const char* fmt, ...);
+	void Throw_error(const char* file, int line, const char* func, const char* fmt, ...);
+
+	// Messages are cut to fit their buffers; user text quoted in them through
+	// "%.*s%s" is cut shorter, with an ellipsis, so the reason stays readable.
+	const unsigned int MAX_QUOTED_LENGTH = 64;
+
+	inline int Quoted_length(size_t length) { return (int)(length > MAX_QUOTED_LENGTH ? MAX_QUOTED_LENGTH : length); }
+	inline const char* Quoted_ellipsis(size_t length) { return length > MAX_QUOTED_LENGTH ? "..." : ""; }
+
+}
+
+//#define INFO(par, ...) Print_info(par, ##__VA_ARGS__)
+//#define WARNING(par, ...) Print_warning(par, ##__VA_ARGS__)
+//#define ERROR(par, ...) Throw_error(par, ##__VA_ARGS__)
+
+#endif // !ERROR_H
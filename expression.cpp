@@ -0,0 +1,231 @@
+#include "expression.h"
+#include "error.h"
+
+
+namespace Math_solver {
+
+	value_t column_t::load(size_t row) const
+	{
+		const double* element = data + row * stride;
+
+		if (!is_mat && num_dims == 1)
+			return value_t(element[0]);
+
+		if (is_mat)
+		{
+			glm::dmat4 m(1.0);
+
+			for (unsigned int i = 0; i < num_dims; i++)
+				for (unsigned int j = 0; j < num_dims; j++)
+					m[i][j] = element[i * num_dims + j];
+
+			return value_t(m, num_dims);
+		}
+
+		glm::dvec4 v(0.0);
+
+		for (unsigned int i = 0; i < num_dims; i++)
+			v[i] = element[i];
+
+		return value_t(v, num_dims);
+	}
+
+	unsigned int Store_value(const value_t& value, double* output, size_t capacity)
+	{
+		unsigned int num_components = value.get_num_components();
+
+		if (num_components > capacity)
+			Throw_error(__FILE__, __LINE__, __func__, "Result has %u components, output holds %u", num_components, (unsigned int)capacity);
+
+		if (value.is_mat())
+		{
+			unsigned int num_dims = value.mat.get_num_dims();
+			const glm::dmat4& m = value.mat.to_mat4();
+
+			for (unsigned int i = 0; i < num_dims; i++)
+				for (unsigned int j = 0; j < num_dims; j++)
+					output[i * num_dims + j] = m[i][j];
+		}
+		else
+		{
+			const glm::dvec4& v = value.vec.to_vec4();
+
+			for (unsigned int i = 0; i < num_components; i++)
+				output[i] = v[i];
+		}
+
+		return num_components;
+	}
+
+	shape_t CompiledExpression::get_shape() const
+	{
+		if (!program_ || program_->get_code().empty())
+			return shape_t::unknown();
+
+		shape_t shape = program_->get_code().back().shape;
+
+		return shape.is_guess ? shape_t::unknown() : shape;
+	}
+
+	const value_t CompiledExpression::evaluate() const
+	{
+		return evaluate(Bindings());
+	}
+
+	const value_t CompiledExpression::evaluate(const Bindings& bindings) const
+	{
+		if (bindings.size() < num_parameters_)
+			Throw_error(__FILE__, __LINE__, __func__, "Expected %u parameters, got %u", num_parameters_, (unsigned int)bindings.size());
+
+		if (!program_)
+			return value_t();
+
+		Metrics& metrics = context_->get_metrics();
+		value_t result;
+
+		try
+		{
+			result = program_->run(bindings, &context_->get_rng()); // assignment stores into its slot
+		}
+		catch (...)
+		{
+			metrics.add_exception();
+			throw;
+		}
+
+		metrics.add_evaluations(program_->get_token_counts(), program_->get_num_token_counts(), 1);
+
+		return is_result_ ? result : value_t();
+	}
+
+	void CompiledExpression::check_columns(const std::vector<column_t>& columns) const
+	{
+		if (columns.size() < num_parameters_)
+			Throw_error(__FILE__, __LINE__, __func__, "Expected %u columns, got %u", num_parameters_, (unsigned int)columns.size());
+
+		if (!program_)
+			return;
+
+		for (unsigned int i = 0; i < num_parameters_; i++)
+		{
+			shape_t shape = program_->get_parameter_shape(i);
+
+			if (!shape.is_guess && (shape.num_dims != columns[i].num_dims || shape.is_mat != columns[i].is_mat))
+				Throw_error(__FILE__, __LINE__, __func__, "Column %u doesn't match shape of parameter", i);
+		}
+	}
+
+	void CompiledExpression::evaluate_batch(const std::vector<column_t>& columns, size_t num_rows, double* output, size_t output_stride) const
+	{
+		check_columns(columns);
+
+		if (!program_)
+			return;
+
+		if (is_result_ && output == nullptr)
+			Throw_error(__FILE__, __LINE__, __func__, "Missing output column");
+
+		Metrics& metrics = context_->get_metrics();
+		PhaseTimer timer(metrics);
+
+		try
+		{
+			evaluate_rows(columns, 0, num_rows, output, output_stride, context_->new_stream());
+		}
+		catch (...)
+		{
+			metrics.add_exception();
+			throw;
+		}
+
+		timer.lap(PHASE_EVALUATE);
+		metrics.add_evaluations(program_->get_token_counts(), program_->get_num_token_counts(), num_rows);
+	}
+
+	void CompiledExpression::evaluate_batch(const std::vector<column_t>& columns, size_t num_rows, double* output, size_t output_stride, Scheduler& scheduler, size_t chunk_rows) const
+	{
+		check_columns(columns);
+
+		if (!program_)
+			return;
+
+		if (!is_result_)
+			Throw_error(__FILE__, __LINE__, __func__, "Assignment can't be evaluated in parallel");
+
+		if (output == nullptr)
+			Throw_error(__FILE__, __LINE__, __func__, "Missing output column");
+
+		if (chunk_rows == 0)
+			chunk_rows = 1;
+
+		size_t num_chunks = (num_rows + chunk_rows - 1) / chunk_rows;
+		uint32_t stream = context_->new_stream();
+
+		// workers don't touch the metrics, the calling thread adds all rows once they're done
+		Metrics& metrics = context_->get_metrics();
+		PhaseTimer timer(metrics);
+
+		try
+		{
+			scheduler.run(num_chunks, [&](size_t chunk) {
+				size_t begin = chunk * chunk_rows;
+				size_t end = (begin + chunk_rows < num_rows) ? begin + chunk_rows : num_rows;
+
+				evaluate_rows(columns, begin, end, output, output_stride, stream);
+			});
+		}
+		catch (...)
+		{
+			metrics.add_exception();
+			throw;
+		}
+
+		timer.lap(PHASE_EVALUATE);
+		metrics.add_evaluations(program_->get_token_counts(), program_->get_num_token_counts(), num_rows);
+	}
+
+	void CompiledExpression::evaluate_rows(const std::vector<column_t>& columns, size_t begin, size_t end, double* output, size_t output_stride, uint32_t stream) const
+	{
+		// scalar programs over scalar columns bind and compute plain doubles, rows
+		// whose loaded variables turn out not to be scalars go through values
+		bool is_scalar = program_->is_scalar() && (!is_result_ || output_stride > 0);
+
+		for (const column_t& column : columns)
+			is_scalar = is_scalar && !column.is_mat && column.num_dims == 1;
+
+		// one binding buffer of each kind reused by all rows
+		std::vector<double> scalars(is_scalar ? columns.size() : 0);
+		Bindings bindings(columns.size());
+		RandomStream rng(context_->get_seed(), stream);
+
+		for (size_t row = begin; row < end; row++)
+		{
+			rng.set_row(row);
+
+			if (is_scalar)
+			{
+				double result;
+
+				for (size_t i = 0; i < columns.size(); i++)
+					scalars[i] = columns[i].data[row * columns[i].stride];
+
+				if (program_->run(scalars.data(), scalars.size(), result))
+				{
+					if (is_result_)
+						output[row * output_stride] = result;
+
+					continue;
+				}
+			}
+
+			for (size_t i = 0; i < columns.size(); i++)
+				bindings[i] = columns[i].load(row);
+
+			value_t result = program_->run(bindings.data(), bindings.size(), &rng);
+
+			if (is_result_)
+				Store_value(result, output + row * output_stride, output_stride);
+		}
+	}
+
+}
@@ -0,0 +1,95 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "program.h"
+#include "context.h"
+#include "scheduler.h"
+#include "config.h"
+
+
+namespace Math_solver {
+
+	class Parser;
+
+	// Input column for batch evaluation. Row "i" starts at "data + i * stride",
+	// vectors are stored as "num_dims" doubles, matrices as "num_dims^2" doubles
+	// in column-major order. Stride 0 binds the same value to every row.
+	typedef struct column {
+
+		const double* data;
+		size_t stride;
+		unsigned int num_dims;
+		bool is_mat;
+
+		static column scalar(const double* data, size_t stride = 1) {
+			return { data, stride, 1, false };
+		}
+
+		static column vector(const double* data, unsigned int num_dims, size_t stride) {
+			return { data, stride, num_dims, false };
+		}
+
+		static column matrix(const double* data, unsigned int num_dims, size_t stride) {
+			return { data, stride, num_dims, true };
+		}
+
+		value_t load(size_t row) const;
+
+	} column_t;
+
+	// Writes components of "value" (column-major for matrices), returns their count.
+	unsigned int Store_value(const value_t& value, double* output, size_t capacity);
+
+	// Parsed expression which can be evaluated many times without parsing it again.
+	// Handle is immutable, copies share the same program. Assignment is performed
+	// on every evaluation.
+	class CompiledExpression
+	{
+		friend class Parser;
+
+	private:
+		std::shared_ptr<const Program> program_;
+		Context* context_; // variables and random generator
+
+		unsigned int num_parameters_;
+		bool is_result_;
+
+		void check_columns(const std::vector<column_t>& columns) const;
+		void evaluate_rows(const std::vector<column_t>& columns, size_t begin, size_t end, double* output, size_t output_stride, uint32_t stream) const;
+
+	public:
+		CompiledExpression()
+			: context_(nullptr), num_parameters_(0), is_result_(false)
+		{
+		}
+
+		const value_t evaluate() const;
+		const value_t evaluate(const Bindings& bindings) const;
+
+		// evaluates rows [0, num_rows), parameter "i" is bound to columns[i];
+		// result of each row is written to "output + row * output_stride";
+		// rand() of each row is keyed by the row index in a new stream
+		void evaluate_batch(const std::vector<column_t>& columns, size_t num_rows, double* output, size_t output_stride) const;
+
+		// same as evaluate_batch, rows are split into chunks of "chunk_rows"
+		// evaluated by the scheduler's threads; assignments are rejected since
+		// their stores would race, variables are only read. Results, including
+		// rand(), are the same as of the single-threaded evaluate_batch.
+		void evaluate_batch(const std::vector<column_t>& columns, size_t num_rows, double* output, size_t output_stride, Scheduler& scheduler, size_t chunk_rows = BATCH_CHUNK_ROWS) const;
+
+		// shape of results, unknown if it depends on variables assigned later
+		shape_t get_shape() const;
+
+		const Program* get_program() const { return program_.get(); }
+		Context* get_context() const { return context_; }
+		unsigned int get_num_parameters() const { return num_parameters_; }
+		bool is_result() const { return is_result_; }
+	};
+
+}
+
+#endif // !EXPRESSION_H
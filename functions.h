@@ -1,69 +1,213 @@
-#ifndef FUNCTIONS_H
-#define FUNCTIONS_H
-
-#include <string>
-
-
-namespace Math_solver {
-
-	enum TokenType
-	{
-		NONE,
-		SCALAR,
-		VARIABLE_ASSIGN,
-		VARIABLE_SUBSTITUTION,
-		END,
-		RAD_FN,
-		DEG_FN,
-		SIN_FN,
-		COS_FN,
-		TAN_FN,
-		SINH_FN,
-		COSH_FN,
-		TANH_FN,
-		ASIN_FN,
-		ACOS_FN,
-		ATAN_FN,
-		ABS_FN,
-		LN_FN,
-		LOG_FN,
-		EXP_FN,
-		SQRT_FN,
-		VEC2_FN,
-		VEC3_FN,
-		VEC4_FN,
-		LENGTH_FN,
-		NORMALIZE_FN,
-		DOT_PRODUCT_FN,
-		CROSS_PRODUCT_FN,
-		MIX_FN,
-		MAT2_FN,
-		MAT3_FN,
-		MAT4_FN,
-		SCALE_FN,
-		ROTATE_FN = 66,
-		TRANSLATE_FN,
-		INVERSE_TRANSPOSE_FN,
-		PERSPECTIVE_PROJ_FN,
-		ORTHO_PROJ_FN,
-		RAND_FN,
-		PLUS = '+',
-		MINUS = '-',
-		MULTIPLY = '*',
-		DIVIDE = '/',
-		MODULO = '%',
-		FACTORIAL = '!',
-		POW = '^',
-		LHPAREN = '(',
-		RHPAREN = ')',
-		COMMA = ',',
-		BLOCK_START = '{',
-		BLOCK_END = '}'
-	};
-
-
-	TokenType CheckFunction(std::string name);
-
-}
-
-#endif // !FUNCTIONS_H
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "constants.h"
+
+
+namespace Math_solver {
+
+	enum TokenType
+	{
+		NONE,
+		SCALAR,
+		VARIABLE_ASSIGN,
+		VARIABLE_REFERENCE,
+		END,
+		RAD_FN,
+		DEG_FN,
+		SIN_FN,
+		COS_FN,
+		TAN_FN,
+		SINH_FN,
+		COSH_FN,
+		TANH_FN,
+		ASIN_FN,
+		ACOS_FN,
+		ATAN_FN,
+		ABS_FN,
+		LN_FN,
+		LOG_FN,
+		EXP_FN,
+		SQRT_FN,
+		VEC2_FN,
+		VEC3_FN,
+		VEC4_FN,
+		LENGTH_FN,
+		NORMALIZE_FN,
+		DOT_PRODUCT_FN,
+		CROSS_PRODUCT_FN,
+		MIX_FN,
+		MAT2_FN,
+		MAT3_FN,
+		MAT4_FN,
+		SCALE_FN,
+		ROTATE_FN = 66,
+		TRANSLATE_FN,
+		INVERSE_TRANSPOSE_FN,
+		PERSPECTIVE_PROJ_FN,
+		ORTHO_PROJ_FN,
+		RAND_FN,
+		VARIABLE_PARAMETER,
+		PLUS = '+',
+		MINUS = '-',
+		MULTIPLY = '*',
+		DIVIDE = '/',
+		MODULO = '%',
+		FACTORIAL = '!',
+		POW = '^',
+		LHPAREN = '(',
+		RHPAREN = ')',
+		COMMA = ',',
+		BLOCK_START = '{',
+		BLOCK_END = '}'
+	};
+
+	typedef struct builtin_function {
+		const char* name;
+		unsigned int length;
+		TokenType token;
+	} builtin_function_t;
+
+	constexpr unsigned int Name_length(const char* name)
+	{
+		unsigned int length = 0;
+
+		while (name[length] != 0)
+			length++;
+
+		return length;
+	}
+
+	constexpr builtin_function_t Builtin(const char* name, TokenType token)
+	{
+		return { name, Name_length(name), token };
+	}
+
+	// names of built-in functions, read-only and shared by parsers and tooling
+	constexpr builtin_function_t BUILTIN_FUNCTIONS[] =
+	{
+		Builtin("RAD", RAD_FN),
+		Builtin("DEG", DEG_FN),
+		Builtin("sin", SIN_FN),
+		Builtin("cos", COS_FN),
+		Builtin("tan", TAN_FN),
+		Builtin("sinh", SINH_FN),
+		Builtin("cosh", COSH_FN),
+		Builtin("tanh", TANH_FN),
+		Builtin("asin", ASIN_FN),
+		Builtin("acos", ACOS_FN),
+		Builtin("atan", ATAN_FN),
+		Builtin("abs", ABS_FN),
+		Builtin("ln", LN_FN),
+		Builtin("log", LOG_FN),
+		Builtin("exp", EXP_FN),
+		Builtin("sqrt", SQRT_FN),
+		Builtin("vec2", VEC2_FN),
+		Builtin("vec3", VEC3_FN),
+		Builtin("vec4", VEC4_FN),
+		Builtin("length", LENGTH_FN),
+		Builtin("normalize", NORMALIZE_FN),
+		Builtin("dot", DOT_PRODUCT_FN),
+		Builtin("cross", CROSS_PRODUCT_FN),
+		Builtin("mix", MIX_FN),
+		Builtin("mat2", MAT2_FN),
+		Builtin("mat3", MAT3_FN),
+		Builtin("mat4", MAT4_FN),
+		Builtin("scale", SCALE_FN),
+		Builtin("rotate", ROTATE_FN),
+		Builtin("translate", TRANSLATE_FN),
+		Builtin("invtranspose", INVERSE_TRANSPOSE_FN),
+		Builtin("perspective", PERSPECTIVE_PROJ_FN),
+		Builtin("ortho", ORTHO_PROJ_FN),
+		Builtin("rand", RAND_FN)
+	};
+
+	constexpr unsigned int NUM_BUILTIN_FUNCTIONS = sizeof(BUILTIN_FUNCTIONS) / sizeof(BUILTIN_FUNCTIONS[0]);
+	constexpr unsigned int FUNCTION_HASH_SIZE = 128; // power of two
+
+	// FNV-1a, "seed" replaces the offset basis; high bits are folded into
+	// the low ones, which alone select the slot
+	constexpr uint32_t Hash_name(const char* name, size_t length, uint32_t seed)
+	{
+		uint32_t hash = seed;
+
+		for (size_t i = 0; i < length; i++)
+			hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+
+		return hash ^ (hash >> 16);
+	}
+
+	// Perfect hash over BUILTIN_FUNCTIONS - slot of name "s" is
+	// Hash_name(s, seed) & (FUNCTION_HASH_SIZE - 1), holding its index or -1.
+	typedef struct function_hash {
+		uint32_t seed;
+		signed char slots[FUNCTION_HASH_SIZE];
+	} function_hash_t;
+
+	// tries seeds until no two names share a slot
+	constexpr function_hash_t Build_function_hash()
+	{
+		function_hash_t table = {};
+
+		for (uint32_t seed = 2166136261u; ; seed++)
+		{
+			bool is_perfect = true;
+
+			for (unsigned int i = 0; i < FUNCTION_HASH_SIZE; i++)
+				table.slots[i] = -1;
+
+			for (unsigned int i = 0; i < NUM_BUILTIN_FUNCTIONS && is_perfect; i++)
+			{
+				uint32_t slot = Hash_name(BUILTIN_FUNCTIONS[i].name, BUILTIN_FUNCTIONS[i].length, seed) & (FUNCTION_HASH_SIZE - 1);
+
+				if (table.slots[slot] != -1)
+					is_perfect = false;
+				else
+					table.slots[slot] = (signed char)i;
+			}
+
+			if (is_perfect)
+			{
+				table.seed = seed;
+				return table;
+			}
+		}
+	}
+
+	constexpr function_hash_t FUNCTION_HASH = Build_function_hash();
+
+	static_assert(NUM_BUILTIN_FUNCTIONS < FUNCTION_HASH_SIZE, "Function hash table is too small");
+
+	// returns NONE for names which aren't built-in functions
+	TokenType CheckFunction(const char* name, size_t length);
+
+	inline TokenType CheckFunction(std::string_view name)
+	{
+		return CheckFunction(name.data(), name.size());
+	}
+
+	typedef struct builtin_constant {
+		const char* name;
+		unsigned int length;
+		double value;
+	} builtin_constant_t;
+
+	// built-in constants, can't be reassigned
+	constexpr builtin_constant_t BUILTIN_CONSTANTS[] =
+	{
+		{ "pi", 2, M_PI },
+		{ "e", 1, M_E }
+	};
+
+	constexpr unsigned int NUM_BUILTIN_CONSTANTS = sizeof(BUILTIN_CONSTANTS) / sizeof(BUILTIN_CONSTANTS[0]);
+
+	bool CheckConstant(std::string_view name, double& value);
+
+}
+
+#endif // !FUNCTIONS_H
@@ -0,0 +1,271 @@
+#include "jit.h"
+#include "error.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X86_64
+#endif
+
+
+namespace Math_solver {
+
+	JitCode::JitCode(const std::vector<unsigned char>& bytes)
+		: code_(nullptr), size_(bytes.size())
+	{
+		// written while writable, then switched to executable (never both)
+#if defined(_WIN32)
+		code_ = VirtualAlloc(nullptr, size_, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+		if (code_ == nullptr)
+			Throw_error(__FILE__, __LINE__, __func__, "Can't allocate code memory");
+
+		memcpy(code_, bytes.data(), size_);
+
+		DWORD protection;
+		VirtualProtect(code_, size_, PAGE_EXECUTE_READ, &protection);
+		FlushInstructionCache(GetCurrentProcess(), code_, size_);
+#else
+		code_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (code_ == MAP_FAILED)
+		{
+			code_ = nullptr;
+			Throw_error(__FILE__, __LINE__, __func__, "Can't allocate code memory");
+		}
+
+		memcpy(code_, bytes.data(), size_);
+
+		if (mprotect(code_, size_, PROT_READ | PROT_EXEC) != 0)
+		{
+			munmap(code_, size_);
+			code_ = nullptr;
+			Throw_error(__FILE__, __LINE__, __func__, "Can't make code memory executable");
+		}
+#endif
+	}
+
+	JitCode::~JitCode()
+	{
+		if (code_ == nullptr)
+			return;
+
+#if defined(_WIN32)
+		VirtualFree(code_, 0, MEM_RELEASE);
+#else
+		munmap(code_, size_);
+#endif
+	}
+
+#ifdef JIT_X86_64
+
+	// Machine code writer, values are addressed as [rbx + 8 * position].
+	class Assembler
+	{
+	private:
+		std::vector<unsigned char> bytes_;
+
+		void emit(std::initializer_list<unsigned char> bytes)
+		{
+			bytes_.insert(bytes_.end(), bytes);
+		}
+
+		void emit32(uint32_t value)
+		{
+			for (unsigned int i = 0; i < 4; i++)
+				bytes_.push_back((unsigned char)(value >> (8 * i)));
+		}
+
+		void emit64(uint64_t value)
+		{
+			for (unsigned int i = 0; i < 8; i++)
+				bytes_.push_back((unsigned char)(value >> (8 * i)));
+		}
+
+		// ModRM for [rbx + disp32] with "reg" register field
+		void emit_value(unsigned char reg, unsigned int position)
+		{
+			emit({ (unsigned char)(0x83 | (reg << 3)) });
+			emit32(position * sizeof(double));
+		}
+
+	public:
+		void prologue()
+		{
+			emit({ 0x53 });						// push rbx
+			emit({ 0x48, 0x83, 0xEC, 0x20 });	// sub rsp, 32 (shadow space, keeps 16-byte alignment)
+#if defined(_WIN32)
+			emit({ 0x48, 0x89, 0xCB });			// mov rbx, rcx
+#else
+			emit({ 0x48, 0x89, 0xFB });			// mov rbx, rdi
+#endif
+		}
+
+		void epilogue(int status)
+		{
+			emit({ 0xB8 });						// mov eax, status
+			emit32((uint32_t)status);
+			emit({ 0x48, 0x83, 0xC4, 0x20 });	// add rsp, 32
+			emit({ 0x5B });						// pop rbx
+			emit({ 0xC3 });						// ret
+		}
+
+		static const size_t EPILOGUE_SIZE = 11;
+
+		void load(unsigned char xmm, unsigned int position)
+		{
+			emit({ 0xF2, 0x0F, 0x10 });			// movsd xmm, [rbx + disp32]
+			emit_value(xmm, position);
+		}
+
+		void store(unsigned char xmm, unsigned int position)
+		{
+			emit({ 0xF2, 0x0F, 0x11 });			// movsd [rbx + disp32], xmm
+			emit_value(xmm, position);
+		}
+
+		// xmm0 = xmm0 op [value], op is 0x58 add, 0x5C sub, 0x59 mul, 0x5E div
+		void arithmetic(unsigned char op, unsigned int position)
+		{
+			emit({ 0xF2, 0x0F, op });
+			emit_value(0, position);
+		}
+
+		void constant(double value, unsigned int position)
+		{
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			emit({ 0x48, 0xB8 });				// mov rax, imm64
+			emit64(bits);
+			emit({ 0x48, 0x89 });				// mov [rbx + disp32], rax
+			emit_value(0, position);
+		}
+
+		// returns JIT_DIVISION_BY_ZERO if xmm1 == 0.0 (NaN passes, as in C)
+		void check_divisor()
+		{
+			emit({ 0x66, 0x0F, 0x57, 0xD2 });	// xorpd xmm2, xmm2
+			emit({ 0x66, 0x0F, 0x2E, 0xCA });	// ucomisd xmm1, xmm2
+			emit({ 0x7A, (unsigned char)(2 + EPILOGUE_SIZE) });	// jp over
+			emit({ 0x75, (unsigned char)EPILOGUE_SIZE });		// jne over
+			epilogue(JIT_DIVISION_BY_ZERO);
+		}
+
+		void divide_xmm1()
+		{
+			emit({ 0xF2, 0x0F, 0x5E, 0xC1 });	// divsd xmm0, xmm1
+		}
+
+		// arguments in xmm0 (and xmm1), result in xmm0
+		void call(const void* function)
+		{
+			uint64_t address;
+			memcpy(&address, &function, sizeof(address));
+
+			emit({ 0x48, 0xB8 });				// mov rax, imm64
+			emit64(address);
+			emit({ 0xFF, 0xD0 });				// call rax
+		}
+
+		const std::vector<unsigned char>& get_bytes() const { return bytes_; }
+	};
+
+	static double Jit_pow(double base, double exponent)
+	{
+		return pow(base, exponent);
+	}
+
+	std::unique_ptr<JitCode> Jit_compile(const std::vector<ScalarInstruction>& code)
+	{
+		Assembler assembler;
+
+		assembler.prologue();
+
+		for (size_t i = 0; i < code.size(); i++)
+		{
+			const ScalarInstruction& instruction = code[i];
+			unsigned int position = (unsigned int)i;
+
+			switch (instruction.code)
+			{
+			case SCALAR_CONSTANT:
+				assembler.constant(instruction.constant, position);
+				break;
+
+			case SCALAR_PARAMETER:
+			case SCALAR_LOAD:
+				break; // stored by the caller
+
+			case SCALAR_STORE:
+				assembler.load(0, instruction.operands[0]);
+				assembler.store(0, position);
+				break;
+
+			case SCALAR_ADD:
+			case SCALAR_SUBTRACT:
+			case SCALAR_MULTIPLY:
+			{
+				static const unsigned char ops[] = { 0x58, 0x5C, 0x59 };
+
+				assembler.load(0, instruction.operands[0]);
+				assembler.arithmetic(ops[instruction.code - SCALAR_ADD], instruction.operands[1]);
+				assembler.store(0, position);
+				break;
+			}
+
+			case SCALAR_DIVIDE:
+				assembler.load(1, instruction.operands[1]);
+				assembler.check_divisor();
+				assembler.load(0, instruction.operands[0]);
+				assembler.divide_xmm1();
+				assembler.store(0, position);
+				break;
+
+			case SCALAR_OPERATOR:
+				if (instruction.oper != '^') // modulo reports errors by throwing
+					return nullptr;
+
+				assembler.load(0, instruction.operands[0]);
+				assembler.load(1, instruction.operands[1]);
+				assembler.call(reinterpret_cast<const void*>(&Jit_pow));
+				assembler.store(0, position);
+				break;
+
+			case SCALAR_FUNCTION:
+				if (instruction.function == nullptr || instruction.function == Scalar_function(FACTORIAL)) // throws
+					return nullptr;
+
+				assembler.load(0, instruction.operands[0]);
+				assembler.call(reinterpret_cast<const void*>(instruction.function));
+				assembler.store(0, position);
+				break;
+
+			default:
+				return nullptr;
+			}
+		}
+
+		assembler.epilogue(JIT_OK);
+
+		return std::unique_ptr<JitCode>(new JitCode(assembler.get_bytes()));
+	}
+
+#else
+
+	std::unique_ptr<JitCode> Jit_compile(const std::vector<ScalarInstruction>& code)
+	{
+		return nullptr;
+	}
+
+#endif // JIT_X86_64
+
+}
@@ -0,0 +1,51 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "program.h"
+
+
+namespace Math_solver {
+
+	enum JitStatus
+	{
+		JIT_OK,
+		JIT_DIVISION_BY_ZERO
+	};
+
+	// Native x86-64 code of a scalar program. The generated function gets the
+	// array of instruction values with parameters and variables already stored
+	// in it and computes the rest with SSE2 arithmetic; element functions and
+	// powers are called through their libm function pointers. Only code which
+	// can't throw is called, so no exception ever unwinds through it.
+	class JitCode
+	{
+	private:
+		typedef int (*entry_t)(double* values);
+
+		void* code_;
+		size_t size_;
+
+	public:
+		explicit JitCode(const std::vector<unsigned char>& bytes);
+		~JitCode();
+
+		JitCode(const JitCode&) = delete;
+		JitCode& operator=(const JitCode&) = delete;
+
+		// returns JitStatus
+		int run(double* values) const { return reinterpret_cast<entry_t>(code_)(values); }
+
+		size_t get_size() const { return size_; }
+	};
+
+	// returns nullptr if the platform isn't supported or the program uses an
+	// operation the compiler doesn't handle - the interpreter is used then
+	std::unique_ptr<JitCode> Jit_compile(const std::vector<ScalarInstruction>& code);
+
+}
+
+#endif // !JIT_H
@@ -1,42 +1,124 @@
-
-// Expression parser to solve simple math problems..
-// Original thought: 31.5.2010 (significantly inspired by one old project on "codeproject.com")
-// Author: Vilm Pantlk
-
-#include "parser.h"
-#include "config.h"
-
-
-int main()
-{
-	std::string inputline;
-
-	try
-	{
-		while(true)
-		{
-			std::cout << "Enter expression: ";
-			std::getline(std::cin, inputline);
-
-			if(inputline.empty())
-				return 0;
-
-			Math_solver::Parser p(inputline);
-			Math_solver::value_t value = p.Evaluate();
-
-			if (!p.IsResult())
-				continue;
-
-			if (value.is_mat())
-				std::cout << "Result: " << value.mat.to_str(PRECISION) << std::endl;
-			else
-				std::cout << "Result: " << value.vec.to_str(PRECISION) << std::endl;
-		}
-	}
-	catch(std::exception & e)
-	{
-		std::cout << /*"Exception: " <<*/ e.what() << std::endl;
-		return 1;
-	}
-	return 0;
-}
+
+// Expression parser to solve simple math problems..
+// Original thought: 31.5.2010 (significantly inspired by one old project on "codeproject.com")
+// Author: Vilm Pantlk
+
+#include "parser.h"
+#include "script.h"
+#include "config.h"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+
+// math_solver --metrics prints counters of the run to stderr, as JSON
+void Print_metrics(const Math_solver::Context& context)
+{
+	fflush(stdout);
+	fputs(context.get_metrics().to_json().c_str(), stderr);
+}
+
+// math_solver -f <file> runs a script, one statement per line
+int Run_script_file(const char* path, Math_solver::OutputFormat format, bool print_metrics)
+{
+	try
+	{
+		Math_solver::Context context;
+		Math_solver::MappedFile file(path);
+
+		bool is_ok = Math_solver::Run_script(file.get_data(), file.get_size(), context, stdout, format);
+
+		if (print_metrics)
+			Print_metrics(context);
+
+		return is_ok ? 0 : 1;
+	}
+	catch (std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
+// math_solver -b evaluates lines of stdin without prompts, errors don't stop it
+int Run_batch(Math_solver::OutputFormat format, bool print_metrics)
+{
+	Math_solver::Context context;
+
+	bool is_ok = Math_solver::Run_pipe(stdin, stdout, context, format);
+
+	if (print_metrics)
+		Print_metrics(context);
+
+	return is_ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* script = nullptr;
+	bool is_batch = false;
+	bool print_metrics = false;
+	Math_solver::OutputFormat format = Math_solver::OUTPUT_TEXT;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			script = argv[++i];
+		else if (strcmp(argv[i], "-b") == 0)
+			is_batch = true;
+		else if (strcmp(argv[i], "--binary") == 0) // results as binary records
+			format = Math_solver::OUTPUT_BINARY;
+		else if (strcmp(argv[i], "--metrics") == 0)
+			print_metrics = true;
+		else
+		{
+			std::cout << "Usage: math_solver [-f <script> | -b] [--binary] [--metrics]" << std::endl;
+			return 1;
+		}
+	}
+
+#if defined(_WIN32)
+	if (format == Math_solver::OUTPUT_BINARY)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	if (script != nullptr)
+		return Run_script_file(script, format, print_metrics);
+
+	if (is_batch)
+		return Run_batch(format, print_metrics);
+
+	std::string inputline;
+	Math_solver::Context context; // variables live across lines
+
+	try
+	{
+		while(true)
+		{
+			std::cout << "Enter expression: ";
+			std::getline(std::cin, inputline);
+
+			if(inputline.empty())
+				return 0;
+
+			Math_solver::Parser p(inputline, context);
+			Math_solver::value_t value = p.Evaluate();
+
+			if (!p.IsResult())
+				continue;
+
+			if (value.is_mat())
+				std::cout << "Result: " << value.mat.to_str(PRECISION) << std::endl;
+			else
+				std::cout << "Result: " << value.vec.to_str(PRECISION) << std::endl;
+		}
+	}
+	catch(std::exception & e)
+	{
+		std::cout << /*"Exception: " <<*/ e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "metrics.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+namespace Math_solver {
+
+	static const char* NODE_KIND_NAMES[NUM_NODE_KINDS] = { "NumNode", "ParamNode", "VarNode", "AssignNode", "OperNode", "FuncNode" };
+	static const char* PHASE_NAMES[NUM_PHASES] = { "parse", "evaluate", "format" };
+
+	NodeKind Node_kind(TokenType token)
+	{
+		switch (token)
+		{
+		case SCALAR:
+			return NODE_NUM;
+		case VARIABLE_PARAMETER:
+			return NODE_PARAM;
+		case VARIABLE_REFERENCE:
+			return NODE_VAR;
+		case VARIABLE_ASSIGN:
+			return NODE_ASSIGN;
+		case PLUS:
+		case MINUS:
+		case MULTIPLY:
+		case DIVIDE:
+		case MODULO:
+		case POW:
+			return NODE_OPER;
+		default:
+			return NODE_FUNC; // built-in functions and factorial
+		}
+	}
+
+	// writes name of the token into "name" (at least 2 characters long)
+	static const char* Token_name(TokenType token, char* name)
+	{
+		switch (token)
+		{
+		case SCALAR:
+			return "number";
+		case VARIABLE_PARAMETER:
+			return "parameter";
+		case VARIABLE_REFERENCE:
+			return "variable";
+		case VARIABLE_ASSIGN:
+			return "assignment";
+		default:
+			break;
+		}
+
+		for (const builtin_function_t& function : BUILTIN_FUNCTIONS)
+			if (function.token == token)
+				return function.name;
+
+		name[0] = (char)token;
+		name[1] = 0;
+
+		return name;
+	}
+
+	void Metrics::reset()
+	{
+		num_tokens_ = 0;
+		num_names_resolved_ = 0;
+		num_exceptions_ = 0;
+		num_evaluations_ = 0;
+		num_formatted_ = 0;
+
+		memset(nodes_, 0, sizeof(nodes_));
+		memset(evaluated_, 0, sizeof(evaluated_));
+		memset(phase_ns_, 0, sizeof(phase_ns_));
+	}
+
+	static uint64_t Sum_kind(const uint64_t* counts, NodeKind kind)
+	{
+		uint64_t sum = 0;
+
+		for (unsigned int i = 0; i < NUM_TOKEN_TYPES; i++)
+			if (Node_kind(TokenType(i)) == kind)
+				sum += counts[i];
+
+		return sum;
+	}
+
+	uint64_t Metrics::get_num_nodes(NodeKind kind) const
+	{
+		return Sum_kind(nodes_, kind);
+	}
+
+	uint64_t Metrics::get_num_evaluated(NodeKind kind) const
+	{
+		return Sum_kind(evaluated_, kind);
+	}
+
+	// "key": { "NumNode": 1, ... } by kind, or "key": { "sin": 2, ... } by token
+	static void Append_counts(std::string& json, const char* key, const uint64_t* counts, bool by_kind)
+	{
+		char text[128];
+
+		snprintf(text, sizeof(text), "  \"%s\": {", key);
+		json += text;
+
+		const char* separator = " ";
+
+		for (unsigned int i = 0; i < (by_kind ? NUM_NODE_KINDS : NUM_TOKEN_TYPES); i++)
+		{
+			if (by_kind)
+				snprintf(text, sizeof(text), "%s\"%s\": %llu", separator, NODE_KIND_NAMES[i], (unsigned long long)Sum_kind(counts, NodeKind(i)));
+			else if (counts[i] != 0)
+			{
+				char name[2];
+				snprintf(text, sizeof(text), "%s\"%s\": %llu", separator, Token_name(TokenType(i), name), (unsigned long long)counts[i]);
+			}
+			else
+				continue;
+
+			json += text;
+			separator = ", ";
+		}
+
+		json += " }";
+	}
+
+	std::string Metrics::to_json() const
+	{
+		std::string json = "{\n";
+		char text[256];
+
+		snprintf(text, sizeof(text), "  \"tokens\": %llu,\n  \"names_resolved\": %llu,\n  \"exceptions\": %llu,\n  \"evaluations\": %llu,\n  \"formatted\": %llu,\n",
+			(unsigned long long)num_tokens_, (unsigned long long)num_names_resolved_, (unsigned long long)num_exceptions_,
+			(unsigned long long)num_evaluations_, (unsigned long long)num_formatted_);
+		json += text;
+
+		Append_counts(json, "nodes", nodes_, true);
+		json += ",\n";
+		Append_counts(json, "nodes_by_token", nodes_, false);
+		json += ",\n";
+		Append_counts(json, "evaluated", evaluated_, true);
+		json += ",\n";
+		Append_counts(json, "evaluated_by_token", evaluated_, false);
+		json += ",\n  \"phase_ns\": {";
+
+		for (unsigned int phase = 0; phase < NUM_PHASES; phase++)
+		{
+			snprintf(text, sizeof(text), "%s\"%s\": %llu", (phase == 0) ? " " : ", ", PHASE_NAMES[phase], (unsigned long long)phase_ns_[phase]);
+			json += text;
+		}
+
+		json += " }\n}\n";
+
+		return json;
+	}
+
+}
@@ -0,0 +1,127 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "functions.h"
+
+
+namespace Math_solver {
+
+	enum Phase : unsigned int
+	{
+		PHASE_PARSE,	// parsing, folding and lowering to a program
+		PHASE_EVALUATE,
+		PHASE_FORMAT,	// results of scripts and pipes
+		NUM_PHASES
+	};
+
+	// kinds of expression tree nodes, each of them is lowered to one instruction
+	enum NodeKind : unsigned int
+	{
+		NODE_NUM,
+		NODE_PARAM,
+		NODE_VAR,
+		NODE_ASSIGN,
+		NODE_OPER,
+		NODE_FUNC,
+		NUM_NODE_KINDS
+	};
+
+	const unsigned int NUM_TOKEN_TYPES = 128; // TokenType values, operators are their characters
+	const unsigned int MAX_NODE_TOKENS = 64; // distinct tokens nodes can have
+
+	NodeKind Node_kind(TokenType token);
+
+	// how many nodes of a program have the same token, evaluation adds them up
+	typedef struct token_count {
+		TokenType token;
+		unsigned int count;
+	} token_count_t;
+
+	// Counters of the work done in one context, always collected. They are
+	// plain integers updated by the thread using the context, like its
+	// variables; batches add up the rows of their workers once they finish.
+	//
+	// Phase times come from clock reads around compilation, batches, one-shot
+	// evaluation and formatting of script results. Evaluation of a compiled
+	// expression is only counted - reading the clock costs as much as that.
+	class Metrics
+	{
+	private:
+		uint64_t num_tokens_;
+		uint64_t num_names_resolved_;	// variables and parameters read by expressions, resolved while parsing
+		uint64_t num_exceptions_;
+		uint64_t num_evaluations_;
+		uint64_t num_formatted_;
+		uint64_t nodes_[NUM_TOKEN_TYPES];		// allocated by parsers
+		uint64_t evaluated_[NUM_TOKEN_TYPES];	// instructions run, one per node
+		uint64_t phase_ns_[NUM_PHASES];
+
+	public:
+		Metrics()
+		{
+			reset();
+		}
+
+		void reset();
+
+		void add_tokens(uint64_t count) { num_tokens_ += count; }
+		void add_names_resolved(uint64_t count) { num_names_resolved_ += count; }
+		void add_exception() { num_exceptions_++; }
+		void add_formatted() { num_formatted_++; }
+		void add_node(TokenType token) { nodes_[token % NUM_TOKEN_TYPES]++; }
+		void add_time(Phase phase, uint64_t ns) { phase_ns_[phase] += ns; }
+
+		// "count" runs of a program, whose nodes are counted in "tokens"
+		void add_evaluations(const token_count_t* tokens, unsigned int num_tokens, uint64_t count)
+		{
+			num_evaluations_ += count;
+
+			for (unsigned int i = 0; i < num_tokens; i++)
+				evaluated_[tokens[i].token % NUM_TOKEN_TYPES] += tokens[i].count * count;
+		}
+
+		uint64_t get_num_tokens() const { return num_tokens_; }
+		uint64_t get_num_names_resolved() const { return num_names_resolved_; }
+		uint64_t get_num_exceptions() const { return num_exceptions_; }
+		uint64_t get_num_evaluations() const { return num_evaluations_; }
+		uint64_t get_num_formatted() const { return num_formatted_; }
+		uint64_t get_num_nodes(TokenType token) const { return nodes_[token % NUM_TOKEN_TYPES]; }
+		uint64_t get_num_nodes(NodeKind kind) const;
+		uint64_t get_num_evaluated(TokenType token) const { return evaluated_[token % NUM_TOKEN_TYPES]; }
+		uint64_t get_num_evaluated(NodeKind kind) const;
+		uint64_t get_phase_ns(Phase phase) const { return phase_ns_[phase]; }
+
+		// every counter, tokens of nodes only if they occurred
+		std::string to_json() const;
+	};
+
+	// Adds time since the previous lap (or construction) to a phase, so
+	// consecutive phases share their clock reads.
+	class PhaseTimer
+	{
+	private:
+		Metrics& metrics_;
+		std::chrono::steady_clock::time_point last_;
+
+	public:
+		explicit PhaseTimer(Metrics& metrics)
+			: metrics_(metrics), last_(std::chrono::steady_clock::now())
+		{
+		}
+
+		void lap(Phase phase)
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			metrics_.add_time(phase, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+			last_ = now;
+		}
+	};
+
+}
+
+#endif // !METRICS_H
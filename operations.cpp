@@ -1,479 +1,938 @@
-#include "constants.h"
-#include "types.h"
-#include "operations.h"
-#include "error.h"
-
-#include <random>
-
-#include <vector>
-#include <iostream>
-#include <algorithm>
-
-
-namespace Math_solver {
-
-	// RAND() 
-	std::random_device dev;
-	std::mt19937 rng(dev());
-
-	// create distributions
-	std::uniform_int_distribution<std::mt19937::result_type> dist_in_range(0, RANDOM_MAX); // distribution in range [0, RANDOM_MAX]
-	//std::uniform_int_distribution<std::mt19937::result_type> dist_in_rand_max;
-	//std::normal_distribution<double> normal_dist(mean, stddeviation);  // N(mean, stddeviation)
-	// RAND() 
-
-	double Radians(double degrees)
-	{
-		return (degrees * (M_PI / 180));
-	}
-
-	double Degrees(double radians)
-	{
-		return ((radians * 180) / M_PI);
-	}
-
-	double RoundOff(double value, unsigned int precision)
-	{
-		double pow_10 = pow(10.0, (double)precision);
-		
-		return round(value * pow_10) / pow_10;
-	}
-
-	double Factorial(double value)
-	{
-		if (ceil(value) == value && value > 0) // integer
-		{
-			double result = value;
-
-			for (unsigned long i = (unsigned long)(result - 1); i > 0; i--)
-				result *= i;
-
-			return result;
-		}
-		else
-			Throw_error(__FILE__, __LINE__, __func__, "Parameter must be integer number greater than zero");
-
-		return 0;
-	}
-
-	double Random(double value)
-	{
-		if (ceil(value) == value && value >= 0 && value < RANDOM_MAX) // integer
-		{
-			return (double)(dist_in_range(rng) % (unsigned int)value);
-		}
-		else
-			Throw_error(__FILE__, __LINE__, __func__, "Parameter must be integer number in range 0..999");
-
-		return 0;
-	}
-
-	std::string Format_number(double value, unsigned int precision)
-	{
-		value = RoundOff(value, precision);
-
-		std::string result = std::to_string(fabs(value));
-		bool is_decimal = (ceil(value) != value);
-		bool is_negative = (value < 0);
-
-		size_t decimal_pos = result.find('.');
-		std::string integer_part = result.substr(0, decimal_pos);
-		std::string decimal_part = result.substr(decimal_pos + 1);
-
-		// integer part
-		std::reverse(integer_part.begin(), integer_part.end());
-
-		for (std::string::size_type i = 0; i < integer_part.size(); i++) { // add thousands separators
-			if ((i != 0) && ((i + 1) % 4 == 0))
-				integer_part.insert(i, 1, ',');
-		}
-
-		std::reverse(integer_part.begin(), integer_part.end());
-
-		if (is_negative)
-			integer_part.insert(0, 1, '-');
-
-		result = integer_part;
-
-		// decimal part
-		if (is_decimal) {
-			std::reverse(decimal_part.begin(), decimal_part.end());
-
-			while (decimal_part[0] == '0') { // erase end zeroes
-				decimal_part.erase(0, 1);
-			}
-
-			std::reverse(decimal_part.begin(), decimal_part.end());
-
-			if (decimal_part.length() != 0) {
-				result += '.';
-				result += decimal_part;
-			}
-		}
-
-		return result;
-	}
-
-	value_t Do_vector(value_t value, double (*fnc)(double))
-	{
-		glm::dvec4 result_temp(0);
-
-		for (unsigned int i = 0; i < value.vec.get_num_dims(); i++)
-			result_temp[i] = fnc((double)value.vec.to_vec4()[i]);
-
-		return value_t(result_temp, value.vec.get_num_dims());
-	}
-
-	value_t Do_vector_scalar(value_t lvalue, value_t rvalue, double (*fnc)(double, double))
-	{
-		glm::dvec4 result_temp(0);
-
-		for (unsigned int i = 0; i < lvalue.vec.get_num_dims(); i++)
-			result_temp[i] = fnc((double)lvalue.vec.to_vec4()[i], (double)rvalue.vec.to_vec4()[0]);
-
-		return value_t(result_temp, lvalue.vec.get_num_dims());
-	}
-
-	value_t Do_vector_vector(value_t lvalue, value_t rvalue, double (*fnc)(double, double))
-	{
-		glm::dvec4 result_temp(0);
-
-		for (unsigned int i = 0; i < lvalue.vec.get_num_dims(); i++)
-			result_temp[i] = fnc((double)lvalue.vec.to_vec4()[i], (double)rvalue.vec.to_vec4()[i]);
-
-		return value_t(result_temp, lvalue.vec.get_num_dims());
-	}
-
-	value_t Do_matrix_scalar(value_t lvalue, value_t rvalue, double (*fnc)(double, double))
-	{
-		glm::dmat4 result_temp = glm::dmat4(0);
-
-		for (unsigned int i = 0; i < lvalue.mat.get_num_dims(); i++)
-			for (unsigned int j = 0; j < lvalue.mat.get_num_dims(); j++)
-				result_temp[i][j] = fnc((double)lvalue.mat.to_mat4()[i][j], (double)rvalue.vec.to_vec4()[0]);
-
-		return value_t(result_temp, lvalue.vec.get_num_dims());
-	}
-
-	value_t Do_func(TokenType func, BaseNode* expression1, BaseNode* expression2, BaseNode* expression3, BaseNode* expression4)
-	{
-		value_t result, first, second, third, fourth;
-		unsigned int num_dims;
-
-		switch (func)
-		{
-		case RAD_FN:
-			return Do_vector(expression1->value(), Radians);
-		case DEG_FN:
-			return Do_vector(expression1->value(), Degrees);
-		case SIN_FN:
-			return Do_vector(expression1->value(), sin);
-		case COS_FN:
-			return Do_vector(expression1->value(), cos);
-		case TAN_FN:
-			return Do_vector(expression1->value(), tan);
-		case SINH_FN:
-			return Do_vector(expression1->value(), sinh);
-		case COSH_FN:
-			return Do_vector(expression1->value(), cosh);
-		case TANH_FN:
-			return Do_vector(expression1->value(), tanh);
-		case ASIN_FN:
-			return Do_vector(expression1->value(), asin);
-		case ACOS_FN:
-			return Do_vector(expression1->value(), acos);
-		case ATAN_FN:
-			return Do_vector(expression1->value(), atan);
-		case ABS_FN:
-			return Do_vector(expression1->value(), fabs);
-		case LN_FN:
-			return Do_vector(expression1->value(), log);
-		case LOG_FN:
-			return Do_vector(expression1->value(), log10);
-		case EXP_FN:
-			return Do_vector(expression1->value(), exp);
-		case SQRT_FN:
-			return Do_vector(expression1->value(), sqrt);
-		case LENGTH_FN:
-			switch (expression1->value().vec.get_num_dims())
-			{
-			case 1:
-				result.vec.set_scalar(expression1->value().vec.to_scalar());
-				break;
-			case 2:
-				result.vec.set_scalar(glm::length(expression1->value().vec.to_vec2()));
-				break;
-			case 3:
-				result.vec.set_scalar(glm::length(expression1->value().vec.to_vec3()));
-				break;
-			case 4:
-				result.vec.set_scalar(glm::length(expression1->value().vec.to_vec4()));
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
-			}
-
-			return result;
-		case NORMALIZE_FN:
-			switch (expression1->value().vec.get_num_dims())
-			{
-			case 2:
-				result.vec.set_vec2(glm::normalize(expression1->value().vec.to_vec2()));
-				break;
-			case 3:
-				result.vec.set_vec3(glm::normalize(expression1->value().vec.to_vec3()));
-				break;
-			case 4:
-				result.vec.set_vec4(glm::normalize(expression1->value().vec.to_vec4()));
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
-			}
-
-			return result;
-		case DOT_PRODUCT_FN:
-			first = expression1->value();
-			second = expression2->value();
-
-			if (first.vec.get_num_dims() != second.vec.get_num_dims())
-				Throw_error(__FILE__, __LINE__, __func__, "Different dimension count at n-dimensional function");
-
-			switch (first.vec.get_num_dims())
-			{
-			case 2:
-				result.vec.set_scalar(glm::dot(first.vec.to_vec2(), second.vec.to_vec2()));
-				break;
-			case 3:
-				result.vec.set_scalar(glm::dot(first.vec.to_vec3(), second.vec.to_vec3()));
-				break;
-			case 4:
-				result.vec.set_scalar(glm::dot(first.vec.to_vec4(), second.vec.to_vec4()));
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
-			}
-
-			return result;
-		case CROSS_PRODUCT_FN:
-			first = expression1->value();
-			second = expression2->value();
-
-			if ((first.vec.get_num_dims() != 3) && (second.vec.get_num_dims() != 3))
-				Throw_error(__FILE__, __LINE__, __func__, "Different dimension count at n-dimensional function");
-
-			result.vec.set_vec3(glm::cross(first.vec.to_vec3(), second.vec.to_vec3()));
-
-			return result;
-		case MIX_FN:
-			first = expression1->value();
-			second = expression2->value();
-			third = expression3->value();
-
-			if (first.vec.get_num_dims() != second.vec.get_num_dims())
-				Throw_error(__FILE__, __LINE__, __func__, "Different dimension count at n-dimensional function");
-
-			if (third.vec.get_num_dims() != 1)
-				Throw_error(__FILE__, __LINE__, __func__, "Third parameter of function must be scalar value");
-
-			switch (first.vec.get_num_dims())
-			{
-			case 1:
-				result.vec.set_scalar(glm::mix(first.vec.to_scalar(), second.vec.to_scalar(), third.vec.to_scalar()));
-				break;
-			case 2:
-				result.vec.set_vec2(glm::mix(first.vec.to_vec2(), second.vec.to_vec2(), third.vec.to_scalar()));
-				break;
-			case 3:
-				result.vec.set_vec3(glm::mix(first.vec.to_vec3(), second.vec.to_vec3(), third.vec.to_scalar()));
-				break;
-			case 4:
-				result.vec.set_vec4(glm::mix(first.vec.to_vec4(), second.vec.to_vec4(), third.vec.to_scalar()));
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
-			}
-
-			return result;
-		case MAT2_FN:
-			first = expression1->value();
-			num_dims = expression1->value().mat.get_num_dims();
-			
-			if (!first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
-
-			switch (num_dims)
-			{
-			case 2:
-				result.mat.set_mat2(first.mat.to_mat2());
-				break;
-			case 3:
-				result.mat.set_mat2(first.mat.to_mat3());
-				break;
-			case 4:
-				result.mat.set_mat2(first.mat.to_mat4());
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
-			}
-
-			return result;
-		case MAT3_FN:
-			first = expression1->value();
-			num_dims = expression1->value().mat.get_num_dims();
-
-			if (!first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
-
-			switch (num_dims)
-			{
-			case 2:
-				result.mat.set_mat3(first.mat.to_mat2());
-				break;
-			case 3:
-				result.mat.set_mat3(first.mat.to_mat3());
-				break;
-			case 4:
-				result.mat.set_mat3(first.mat.to_mat4());
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
-			}
-
-			return result;
-		case MAT4_FN:
-			first = expression1->value();
-			num_dims = expression1->value().mat.get_num_dims();
-
-			if (!first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
-
-			switch (num_dims)
-			{
-			case 2:
-				result.mat.set_mat4(first.mat.to_mat2());
-				break;
-			case 3:
-				result.mat.set_mat4(first.mat.to_mat3());
-				break;
-			case 4:
-				result.mat.set_mat4(first.mat.to_mat4());
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
-			}
-
-			return result;
-		case SCALE_FN:
-			first = expression1->value();
-			second = expression2->value();
-
-			if (!first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
-			if (second.is_mat() || second.vec.get_num_dims() != 3)
-				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be 3D vector");
-
-			result.mat.set_mat4(glm::scale((glm::mat4)first.mat.to_mat4(), (glm::vec3)second.vec.to_vec3()));
-
-			return result;
-		case ROTATE_FN:
-			first = expression1->value();
-			second = expression2->value();
-			third = expression3->value();
-
-			if (!first.is_mat() || first.mat.get_num_dims() != 4)
-				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
-			if (second.vec.get_num_dims() != 1)
-				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be scalar");
-			if (third.is_mat() || third.vec.get_num_dims() != 3)
-				Throw_error(__FILE__, __LINE__, __func__, "Third parameter must be 3D vector");
-
-			result.mat.set_mat4(glm::rotate(first.mat.to_mat4(), second.vec.to_scalar(), third.vec.to_vec3()));
-
-			return result;
-		case TRANSLATE_FN:
-			first = expression1->value();
-			second = expression2->value();
-
-			if (!first.is_mat() || first.mat.get_num_dims() != 4)
-				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
-			if (second.is_mat() || second.vec.get_num_dims() != 3)
-				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be 3D vector");
-
-			result.mat.set_mat4(glm::translate(first.mat.to_mat4(), second.vec.to_vec3()));
-
-			return result;
-		case INVERSE_TRANSPOSE_FN:
-			first = expression1->value();
-
-			if (!first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
-
-			switch (first.vec.get_num_dims())
-			{
-			case 2:
-				result.mat.set_mat2(glm::inverseTranspose(first.mat.to_mat2()));
-				break;
-			case 3:
-				result.mat.set_mat3(glm::inverseTranspose(first.mat.to_mat3()));
-				break;
-			case 4:
-				result.mat.set_mat4(glm::inverseTranspose(first.mat.to_mat4()));
-				break;
-			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vectors");
-			}
-
-			return result;
-		case PERSPECTIVE_PROJ_FN:
-			first = expression1->value();
-			second = expression2->value();
-			third = expression3->value();
-			fourth = expression4->value();
-
-			if (first.is_mat() || second.is_mat() || third.is_mat() || fourth.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "None of the parameters can't be matrix");
-			if (first.vec.get_num_dims() != 1 ||
-				second.vec.get_num_dims() != 1 ||
-				third.vec.get_num_dims() != 1 ||
-				fourth.vec.get_num_dims() != 1)
-				Throw_error(__FILE__, __LINE__, __func__, "All parameters must be scalar");
-
-			result.mat.set_mat4(glm::perspective(
-				first.vec.to_scalar(),
-				second.vec.to_scalar(),
-				third.vec.to_scalar(),
-				fourth.vec.to_scalar()));
-
-			return result;
-		case ORTHO_PROJ_FN:
-			first = expression1->value();
-			second = expression2->value();
-			third = expression3->value();
-			fourth = expression4->value();
-
-			if (first.is_mat() || second.is_mat() || third.is_mat() || fourth.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "None of the parameters can't be matrix");
-			if (first.vec.get_num_dims() != 1 ||
-				second.vec.get_num_dims() != 1 ||
-				third.vec.get_num_dims() != 1 ||
-				fourth.vec.get_num_dims() != 1)
-				Throw_error(__FILE__, __LINE__, __func__, "All parameters must be scalar");
-
-			result.mat.set_mat4(glm::ortho(
-				first.vec.to_scalar(),
-				second.vec.to_scalar(),
-				third.vec.to_scalar(),
-				fourth.vec.to_scalar()));
-
-			return result;
-		case RAND_FN:
-			first = expression1->value();
-
-			if (first.is_mat())
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter can't be matrix");
-			if (first.vec.get_num_dims() != 1)
-				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be scalar");
-
-			result.vec.set_scalar(Random(first.vec.to_scalar()));
-
-			return result;
-		default:
-			Throw_error(__FILE__, __LINE__, __func__, "Unknown function: %d", func);
-		}
-
-		return result;
-	}
-
-}
\ No newline at end of file
+#include "constants.h"
+#include "types.h"
+#include "operations.h"
+#include "error.h"
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+
+namespace Math_solver {
+
+	double Radians(double degrees)
+	{
+		return (degrees * (M_PI / 180));
+	}
+
+	double Degrees(double radians)
+	{
+		return ((radians * 180) / M_PI);
+	}
+
+	double RoundOff(double value, unsigned int precision)
+	{
+		double pow_10 = precision < NUM_POWERS_OF_10 ? POWERS_OF_10[precision] : pow(10.0, (double)precision);
+		
+		return round(value * pow_10) / pow_10;
+	}
+
+	double Factorial(double value)
+	{
+		if (ceil(value) == value && value > 0) // integer
+		{
+			double result = value;
+
+			for (unsigned long i = (unsigned long)(result - 1); i > 0; i--)
+				result *= i;
+
+			return result;
+		}
+		else
+			Throw_error(__FILE__, __LINE__, __func__, "Parameter must be integer number greater than zero");
+
+		return 0;
+	}
+
+	double Random(double value, RandomStream& rng)
+	{
+		if (ceil(value) == value && value > 0 && value < RANDOM_MAX) // integer
+		{
+			return (double)rng.next_below((uint32_t)value); // [0, value)
+		}
+		else
+			Throw_error(__FILE__, __LINE__, __func__, "Parameter must be integer number in range 1..999");
+
+		return 0;
+	}
+
+	static unsigned int Digit_value(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'z')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'Z')
+			return c - 'A' + 10;
+
+		return 36;
+	}
+
+	const char* Parse_number(const char* text, const char* end, double& value)
+	{
+		const char* p = text;
+		bool is_negative = (p < end && *p == '-');
+
+		if (p < end && (*p == '+' || *p == '-'))
+			p++;
+
+		unsigned int base = 10;
+
+		if (end - p >= 2 && p[0] == '0')
+		{
+			switch (p[1])
+			{
+			case 'b': case 'B': base = 2; break;
+			case 'o': case 'O': base = 8; break;
+			case 'x': case 'X': base = 16; break;
+			}
+		}
+
+		if (base != 10) // integer with prefix
+		{
+			const char* digits = p + 2;
+			uint64_t integer = 0;
+
+			for (p = digits; p < end && isalnum((unsigned char)*p); p++)
+			{
+				unsigned int digit = Digit_value(*p);
+
+				if (digit >= base || integer > (UINT64_MAX - digit) / base)
+					return nullptr;
+
+				integer = integer * base + digit;
+			}
+
+			if (p == digits)
+				return nullptr;
+
+			value = is_negative ? -(double)integer : (double)integer;
+			return p;
+		}
+
+		const char* begin = p;
+
+		while (p < end && (isdigit((unsigned char)*p) || *p == '.'))
+			p++;
+
+		std::from_chars_result result = std::from_chars(begin, p, value);
+
+		if (result.ec != std::errc() || result.ptr != p)
+			return nullptr;
+
+		if (is_negative)
+			value = -value;
+
+		return p;
+	}
+
+	// integer digits of "magnitude" with separators, then "decimals" without trailing zeroes
+	static size_t Write_number(char* buffer, bool is_negative, const char* integer, size_t num_integer, const char* decimals, size_t num_decimals)
+	{
+		char* p = buffer;
+
+		if (is_negative)
+			*p++ = '-';
+
+		for (size_t i = 0; i < num_integer; i++)
+		{
+			if (i != 0 && (num_integer - i) % 3 == 0) // thousands separator
+				*p++ = ',';
+
+			*p++ = integer[i];
+		}
+
+		while (num_decimals != 0 && decimals[num_decimals - 1] == '0')
+			num_decimals--;
+
+		if (num_decimals != 0)
+		{
+			*p++ = '.';
+			memcpy(p, decimals, num_decimals);
+			p += num_decimals;
+		}
+
+		return p - buffer;
+	}
+
+	size_t Format_number(double value, unsigned int precision, char* buffer)
+	{
+		if (std::isnan(value)) {
+			memcpy(buffer, "nan", 3);
+			return 3;
+		}
+
+		// rounded to "precision", then printed with six decimals (as by std::to_string)
+		double pow_10 = precision < NUM_POWERS_OF_10 ? POWERS_OF_10[precision] : pow(10.0, (double)precision);
+		double scaled = round(fabs(value) * pow_10);
+		double rounded = scaled / pow_10;
+		bool is_negative = (value < 0 && scaled != 0);
+
+		if (std::isinf(rounded)) // also when scaling overflows
+			return Write_number(buffer, is_negative, "inf", 3, nullptr, 0);
+
+		char digits[NUMBER_STR_SIZE];
+
+		if (precision <= 6 && rounded < 8589934592.0) // 2^33, "scaled" is an exact integer below 2^53
+		{
+			// digits of the integer, the last "precision" ones are decimals;
+			// "rounded" is the double nearest to them, so they are what %f prints
+			uint64_t integer = (uint64_t)scaled;
+			char* end = digits + sizeof(digits);
+			char* p = end;
+
+			do {
+				*--p = (char)('0' + integer % 10);
+				integer /= 10;
+			} while (integer != 0 || (size_t)(end - p) <= precision);
+
+			size_t num_integer = (end - p) - precision;
+
+			return Write_number(buffer, is_negative, p, num_integer, p + num_integer, precision);
+		}
+
+		int length = snprintf(digits, sizeof(digits), "%.6f", rounded);
+		size_t num_integer = length - 7;
+
+		// decimals of a whole number are zeroes, only shown if not
+		bool is_decimal = (ceil(rounded) != rounded);
+
+		return Write_number(buffer, is_negative, digits, num_integer, digits + num_integer + 1, is_decimal ? 6 : 0);
+	}
+
+	std::string Format_number(double value, unsigned int precision)
+	{
+		char buffer[NUMBER_STR_SIZE];
+
+		return std::string(buffer, Format_number(value, precision, buffer));
+	}
+
+	template<ElementOp OP>
+	static value_t Vector_scalar(const value_t& lvalue, const value_t& rvalue)
+	{
+		double scalar = rvalue.vec.to_scalar();
+
+		if (OP == ELEMENT_DIVIDE && scalar == 0.0) // as Scalar_oper
+			Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+		value_t result(glm::dvec4(0.0), lvalue.vec.get_num_dims());
+
+		Simd_block_vector_scalar<OP>(lvalue.vec.data(), scalar, result.vec.data(), lvalue.vec.get_num_dims());
+
+		return result;
+	}
+
+	template<ElementOp OP>
+	static value_t Vector_vector(const value_t& lvalue, const value_t& rvalue)
+	{
+		value_t result(glm::dvec4(0.0), lvalue.vec.get_num_dims());
+
+		Simd_block_vector_vector<OP>(lvalue.vec.data(), rvalue.vec.data(), result.vec.data(), lvalue.vec.get_num_dims());
+
+		return result;
+	}
+
+	template<ElementOp OP>
+	static value_t Matrix_scalar(const value_t& lvalue, const value_t& rvalue)
+	{
+		static const vector_scalar_kernel_t kernel = Simd_vector_scalar_kernel(OP);
+
+		double scalar = rvalue.vec.to_scalar();
+
+		if (OP == ELEMENT_DIVIDE && scalar == 0.0)
+			Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+		value_t result(glm::dmat4(0.0), lvalue.mat.get_num_dims());
+
+		// one block per column
+		kernel(lvalue.mat.data(), scalar, result.mat.data(), lvalue.mat.get_num_dims(), lvalue.mat.get_num_dims());
+
+		return result;
+	}
+
+	static const element_kernel_t VECTOR_SCALAR_KERNELS[NUM_ELEMENT_OPS] = SIMD_ELEMENT_OPS(Vector_scalar);
+	static const element_kernel_t VECTOR_VECTOR_KERNELS[NUM_ELEMENT_OPS] = SIMD_ELEMENT_OPS(Vector_vector);
+	static const element_kernel_t MATRIX_SCALAR_KERNELS[NUM_ELEMENT_OPS] = SIMD_ELEMENT_OPS(Matrix_scalar);
+
+	element_kernel_t Get_vector_scalar_kernel(ElementOp op)
+	{
+		return VECTOR_SCALAR_KERNELS[op];
+	}
+
+	element_kernel_t Get_vector_vector_kernel(ElementOp op)
+	{
+		return VECTOR_VECTOR_KERNELS[op];
+	}
+
+	element_kernel_t Get_matrix_scalar_kernel(ElementOp op)
+	{
+		return MATRIX_SCALAR_KERNELS[op];
+	}
+
+	value_t Do_vector_scalar(const value_t& lvalue, const value_t& rvalue, ElementOp op)
+	{
+		return VECTOR_SCALAR_KERNELS[op](lvalue, rvalue);
+	}
+
+	value_t Do_vector_vector(const value_t& lvalue, const value_t& rvalue, ElementOp op)
+	{
+		return VECTOR_VECTOR_KERNELS[op](lvalue, rvalue);
+	}
+
+	value_t Do_matrix_scalar(const value_t& lvalue, const value_t& rvalue, ElementOp op)
+	{
+		return MATRIX_SCALAR_KERNELS[op](lvalue, rvalue);
+	}
+
+	// kinds of operands the shape rules accept
+	enum ShapeKind
+	{
+		SHAPE_NONE, // not a parameter of the function, not checked
+		SHAPE_ANY,
+		SHAPE_SCALAR,
+		SHAPE_VECTOR, // 2 to 4 dimensions
+		SHAPE_VEC3,
+		SHAPE_MATRIX,
+		SHAPE_MAT4,
+		SHAPE_NOT_SCALAR, // vector or matrix
+		SHAPE_SAME, // same shape as the first operand
+		SHAPE_SAME_DIMS // as many dimensions as the first operand
+	};
+
+	// shape of the result, "num_dims" 0 takes the dimensions of the first operand
+	enum ResultKind
+	{
+		RESULT_SCALAR,
+		RESULT_VECTOR, // scalar if it has one dimension
+		RESULT_MATRIX,
+		RESULT_LEFT,
+		RESULT_RIGHT
+	};
+
+	typedef struct operator_rule {
+		const char* opers;
+		ShapeKind left;
+		ShapeKind right;
+		ResultKind result;
+	} operator_rule_t;
+
+	typedef struct function_rule {
+		TokenType func;
+		ShapeKind parameters[4];
+		ResultKind result;
+		unsigned int num_dims;
+	} function_rule_t;
+
+	// what Do_oper evaluates, no two rules accept the same operands
+	static const operator_rule_t OPERATOR_RULES[] =
+	{
+		{ "+-*/%^", SHAPE_SCALAR, SHAPE_SCALAR, RESULT_LEFT },
+		{ "+-*/", SHAPE_SCALAR, SHAPE_VECTOR, RESULT_RIGHT },
+		{ "+-*/", SHAPE_VECTOR, SHAPE_SCALAR, RESULT_LEFT },
+		{ "+-", SHAPE_VECTOR, SHAPE_SAME, RESULT_LEFT },
+		{ "*", SHAPE_MATRIX, SHAPE_SAME_DIMS, RESULT_RIGHT }, // matrix times matrix or vector
+		{ "+-*/", SHAPE_MATRIX, SHAPE_SCALAR, RESULT_LEFT },
+		{ "+-*/", SHAPE_SCALAR, SHAPE_MATRIX, RESULT_RIGHT }
+	};
+
+	// what Do_func evaluates; missing parameters are passed as scalar zeroes
+	static const function_rule_t FUNCTION_RULES[] =
+	{
+		{ RAD_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ DEG_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ SIN_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ COS_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ TAN_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ SINH_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ COSH_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ TANH_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ ASIN_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ ACOS_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ ATAN_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ ABS_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ LN_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ LOG_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ EXP_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ SQRT_FN, { SHAPE_ANY }, RESULT_VECTOR, 0 },
+		{ VEC2_FN, { SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR }, RESULT_VECTOR, 2 },
+		{ VEC3_FN, { SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR }, RESULT_VECTOR, 3 },
+		{ VEC4_FN, { SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR }, RESULT_VECTOR, 4 },
+		{ LENGTH_FN, { SHAPE_ANY }, RESULT_SCALAR, 1 },
+		{ NORMALIZE_FN, { SHAPE_NOT_SCALAR }, RESULT_VECTOR, 0 },
+		{ DOT_PRODUCT_FN, { SHAPE_NOT_SCALAR, SHAPE_SAME_DIMS }, RESULT_SCALAR, 1 },
+		{ CROSS_PRODUCT_FN, { SHAPE_VEC3, SHAPE_VEC3 }, RESULT_VECTOR, 3 },
+		{ MIX_FN, { SHAPE_ANY, SHAPE_SAME_DIMS, SHAPE_SCALAR }, RESULT_VECTOR, 0 },
+		{ MAT2_FN, { SHAPE_MATRIX }, RESULT_MATRIX, 2 },
+		{ MAT3_FN, { SHAPE_MATRIX }, RESULT_MATRIX, 3 },
+		{ MAT4_FN, { SHAPE_MATRIX }, RESULT_MATRIX, 4 },
+		{ SCALE_FN, { SHAPE_MATRIX, SHAPE_VEC3 }, RESULT_MATRIX, 4 },
+		{ ROTATE_FN, { SHAPE_MAT4, SHAPE_SCALAR, SHAPE_VEC3 }, RESULT_MATRIX, 4 },
+		{ TRANSLATE_FN, { SHAPE_MAT4, SHAPE_VEC3 }, RESULT_MATRIX, 4 },
+		{ INVERSE_TRANSPOSE_FN, { SHAPE_MATRIX }, RESULT_MATRIX, 0 },
+		{ PERSPECTIVE_PROJ_FN, { SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR }, RESULT_MATRIX, 4 },
+		{ ORTHO_PROJ_FN, { SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR, SHAPE_SCALAR }, RESULT_MATRIX, 4 },
+		{ FACTORIAL, { SHAPE_SCALAR }, RESULT_SCALAR, 1 },
+		{ RAND_FN, { SHAPE_SCALAR }, RESULT_SCALAR, 1 }
+	};
+
+	static bool Is_kind(ShapeKind kind, const shape_t& shape, const shape_t& first)
+	{
+		switch (kind)
+		{
+		case SHAPE_NONE:
+		case SHAPE_ANY:
+			return true;
+		case SHAPE_SCALAR:
+			return shape.is_scalar();
+		case SHAPE_VECTOR:
+			return !shape.is_mat && shape.num_dims > 1;
+		case SHAPE_VEC3:
+			return !shape.is_mat && shape.num_dims == 3;
+		case SHAPE_MATRIX:
+			return shape.is_mat;
+		case SHAPE_MAT4:
+			return shape.is_mat && shape.num_dims == 4;
+		case SHAPE_NOT_SCALAR:
+			return shape.num_dims > 1;
+		case SHAPE_SAME:
+			return shape.num_dims == first.num_dims && shape.is_mat == first.is_mat;
+		case SHAPE_SAME_DIMS:
+			return shape.num_dims == first.num_dims;
+		}
+
+		return false;
+	}
+
+	bool Operator_shape(char oper, const shape_t& left, const shape_t& right, shape_t& result)
+	{
+		for (const operator_rule_t& rule : OPERATOR_RULES)
+		{
+			if (strchr(rule.opers, oper) == nullptr || !Is_kind(rule.left, left, left) || !Is_kind(rule.right, right, left))
+				continue;
+
+			result = (rule.result == RESULT_LEFT) ? left : right;
+			result.is_guess = false;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool Function_shape(TokenType func, const shape_t* parameters, unsigned int num_parameters, shape_t& result)
+	{
+		for (const function_rule_t& rule : FUNCTION_RULES)
+		{
+			if (rule.func != func)
+				continue;
+
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				shape_t shape = (i < num_parameters) ? parameters[i] : shape_t::scalar();
+
+				if (!Is_kind(rule.parameters[i], shape, (num_parameters > 0) ? parameters[0] : shape))
+					return false;
+			}
+
+			unsigned int num_dims = (rule.num_dims != 0) ? rule.num_dims : parameters[0].num_dims;
+
+			switch (rule.result)
+			{
+			case RESULT_MATRIX:
+				result = shape_t::matrix(num_dims);
+				break;
+			case RESULT_VECTOR:
+				result = shape_t::vector(num_dims);
+				break;
+			default:
+				result = shape_t::scalar();
+				break;
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	double Scalar_oper(char oper, double left, double right)
+	{
+		switch (oper)
+		{
+		case '+': return left + right;
+		case '-': return left - right;
+		case '*': return left * right;
+		case '/':
+			if (right == 0.0)
+				Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+			return left / right;
+		case '%':
+			if (ceil(left) == left && ceil(right) == right) // check if integer
+				return (double)((long)left % (long)right);
+			else
+				Throw_error(__FILE__, __LINE__, __func__, "Both operand must be integer");
+
+			return 0;
+		case '^': return pow(left, right);
+		default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar operator: %c", oper);
+		}
+
+		return 0;
+	}
+
+	value_t Do_oper(char oper, const value_t& leftValue, const value_t& rightValue)
+	{
+		value_t result;
+
+		unsigned int lnumdims = leftValue.vec.get_num_dims();
+		unsigned int rnumdims = rightValue.vec.get_num_dims();
+
+		if (!leftValue.is_mat() && !rightValue.is_mat()) // not matrices
+		{
+			if ((lnumdims == 1) && (rnumdims == 1)) // two scalars
+			{
+				return value_t(Scalar_oper(oper, leftValue.vec.to_scalar(), rightValue.vec.to_scalar()));
+			}
+			else if ((lnumdims == 1 && rnumdims != 1)) // one scalar, one vector
+			{
+				switch (oper)
+				{
+				case '+': return Do_vector_scalar(rightValue, leftValue, ELEMENT_ADD);
+				case '-': return Do_vector_scalar(rightValue, leftValue, ELEMENT_SUBTRACT_REVERSED);
+				case '*': return Do_vector_scalar(rightValue, leftValue, ELEMENT_MULTIPLY);
+				case '/': return Do_vector_scalar(rightValue, leftValue, ELEMENT_DIVIDE_REVERSED);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar-vector operator: %c", oper);
+				}
+			}
+			else if ((lnumdims != 1 && rnumdims == 1)) // one vector, one scalar
+			{
+				switch (oper)
+				{
+				case '+': return Do_vector_scalar(leftValue, rightValue, ELEMENT_ADD);
+				case '-': return Do_vector_scalar(leftValue, rightValue, ELEMENT_SUBTRACT);
+				case '*': return Do_vector_scalar(leftValue, rightValue, ELEMENT_MULTIPLY);
+				case '/': return Do_vector_scalar(leftValue, rightValue, ELEMENT_DIVIDE);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown vector-scalar operator: %c", oper);
+				}
+			}
+			else if (lnumdims == rnumdims) // two (same-dimensional) vectors
+			{
+				switch (oper)
+				{
+				case '+': return Do_vector_vector(leftValue, rightValue, ELEMENT_ADD);
+				case '-': return Do_vector_vector(leftValue, rightValue, ELEMENT_SUBTRACT);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown vector-vector operator: %c", oper);
+				}
+			}
+		}
+
+		if (leftValue.is_mat() && rightValue.is_mat()) // matrix-matrix
+		{
+			if (lnumdims == rnumdims) {
+				switch (oper)
+				{
+				case '*': return (leftValue * rightValue);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-matrix operator: %c", oper);
+				}
+			}
+			else
+				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
+		}
+
+		if (leftValue.is_mat() && !rightValue.is_mat()) 
+		{
+			if (lnumdims == rnumdims) { // matrix-vector
+				switch (oper)
+				{
+				case '*': return (leftValue * rightValue);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-vector operator: %c", oper);
+				}
+			}
+			else if (rnumdims == 1) { // matrix-scalar
+				switch (oper)
+				{
+				case '+': return Do_matrix_scalar(leftValue, rightValue, ELEMENT_ADD);
+				case '-': return Do_matrix_scalar(leftValue, rightValue, ELEMENT_SUBTRACT);
+				case '*': return Do_matrix_scalar(leftValue, rightValue, ELEMENT_MULTIPLY);
+				case '/': return Do_matrix_scalar(leftValue, rightValue, ELEMENT_DIVIDE);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-scalar operator: %c", oper);
+				}
+			}
+			else
+				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
+		}
+
+		if (!leftValue.is_mat() && rightValue.is_mat())
+		{
+			if (lnumdims == 1) { // scalar-matrix
+				switch (oper)
+				{
+				case '+': return Do_matrix_scalar(rightValue, leftValue, ELEMENT_ADD);
+				case '-': return Do_matrix_scalar(rightValue, leftValue, ELEMENT_SUBTRACT_REVERSED);
+				case '*': return Do_matrix_scalar(rightValue, leftValue, ELEMENT_MULTIPLY);
+				case '/': return Do_matrix_scalar(rightValue, leftValue, ELEMENT_DIVIDE_REVERSED);
+				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar-matrix operator: %c", oper);
+				}
+			}
+			else
+				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
+		}
+
+		Throw_error(__FILE__, __LINE__, __func__, "Wrong operation");
+
+		return result;
+	}
+
+	double Do_component(const value_t& component)
+	{
+		if (component.is_mat() || component.vec.get_num_dims() != 1)
+			Throw_error(__FILE__, __LINE__, __func__, "Vector component must be scalar");
+
+		return component.vec.to_scalar();
+	}
+
+	scalar_function_t Scalar_function(TokenType func)
+	{
+		switch (func)
+		{
+		case RAD_FN: return Radians;
+		case DEG_FN: return Degrees;
+		case SIN_FN: return [](double x) { return sin(x); };
+		case COS_FN: return [](double x) { return cos(x); };
+		case TAN_FN: return [](double x) { return tan(x); };
+		case SINH_FN: return [](double x) { return sinh(x); };
+		case COSH_FN: return [](double x) { return cosh(x); };
+		case TANH_FN: return [](double x) { return tanh(x); };
+		case ASIN_FN: return [](double x) { return asin(x); };
+		case ACOS_FN: return [](double x) { return acos(x); };
+		case ATAN_FN: return [](double x) { return atan(x); };
+		case ABS_FN: return [](double x) { return fabs(x); };
+		case LN_FN: return [](double x) { return log(x); };
+		case LOG_FN: return [](double x) { return log10(x); };
+		case EXP_FN: return [](double x) { return exp(x); };
+		case SQRT_FN: return [](double x) { return sqrt(x); };
+		case FACTORIAL: return Factorial;
+		default: return nullptr;
+		}
+	}
+
+	value_t Do_func(TokenType func, const value_t& first, const value_t& second, const value_t& third, const value_t& fourth, RandomStream* rng)
+	{
+		value_t result;
+		unsigned int num_dims;
+
+		switch (func)
+		{
+		case RAD_FN:
+			return Do_vector(first, [](double x) { return Radians(x); });
+		case DEG_FN:
+			return Do_vector(first, [](double x) { return Degrees(x); });
+		case SIN_FN:
+			return Do_vector(first, [](double x) { return sin(x); });
+		case COS_FN:
+			return Do_vector(first, [](double x) { return cos(x); });
+		case TAN_FN:
+			return Do_vector(first, [](double x) { return tan(x); });
+		case SINH_FN:
+			return Do_vector(first, [](double x) { return sinh(x); });
+		case COSH_FN:
+			return Do_vector(first, [](double x) { return cosh(x); });
+		case TANH_FN:
+			return Do_vector(first, [](double x) { return tanh(x); });
+		case ASIN_FN:
+			return Do_vector(first, [](double x) { return asin(x); });
+		case ACOS_FN:
+			return Do_vector(first, [](double x) { return acos(x); });
+		case ATAN_FN:
+			return Do_vector(first, [](double x) { return atan(x); });
+		case ABS_FN:
+			return Do_vector(first, [](double x) { return fabs(x); });
+		case LN_FN:
+			return Do_vector(first, [](double x) { return log(x); });
+		case LOG_FN:
+			return Do_vector(first, [](double x) { return log10(x); });
+		case EXP_FN:
+			return Do_vector(first, [](double x) { return exp(x); });
+		case SQRT_FN:
+			return Do_vector(first, [](double x) { return sqrt(x); });
+		case VEC2_FN:
+		case VEC3_FN:
+		case VEC4_FN:
+			num_dims = (func == VEC2_FN) ? 2 : ((func == VEC3_FN) ? 3 : 4);
+
+			return value_t(glm::dvec4(
+				Do_component(first),
+				Do_component(second),
+				Do_component(third),
+				Do_component(fourth)), num_dims);
+		case LENGTH_FN:
+			switch (first.vec.get_num_dims())
+			{
+			case 1:
+				result.vec.set_scalar(first.vec.to_scalar());
+				break;
+			case 2:
+				result.vec.set_scalar(glm::length(first.vec.to_vec2()));
+				break;
+			case 3:
+				result.vec.set_scalar(glm::length(first.vec.to_vec3()));
+				break;
+			case 4:
+				result.vec.set_scalar(glm::length(first.vec.to_vec4()));
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
+			}
+
+			return result;
+		case NORMALIZE_FN:
+			switch (first.vec.get_num_dims())
+			{
+			case 2:
+				result.vec.set_vec2(glm::normalize(first.vec.to_vec2()));
+				break;
+			case 3:
+				result.vec.set_vec3(glm::normalize(first.vec.to_vec3()));
+				break;
+			case 4:
+				result.vec.set_vec4(glm::normalize(first.vec.to_vec4()));
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
+			}
+
+			return result;
+		case DOT_PRODUCT_FN:
+
+			if (first.vec.get_num_dims() != second.vec.get_num_dims())
+				Throw_error(__FILE__, __LINE__, __func__, "Different dimension count at n-dimensional function");
+
+			switch (first.vec.get_num_dims())
+			{
+			case 2:
+				result.vec.set_scalar(glm::dot(first.vec.to_vec2(), second.vec.to_vec2()));
+				break;
+			case 3:
+				result.vec.set_scalar(glm::dot(first.vec.to_vec3(), second.vec.to_vec3()));
+				break;
+			case 4:
+				result.vec.set_scalar(glm::dot(first.vec.to_vec4(), second.vec.to_vec4()));
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
+			}
+
+			return result;
+		case CROSS_PRODUCT_FN:
+
+			if (first.is_mat() || second.is_mat() || first.vec.get_num_dims() != 3 || second.vec.get_num_dims() != 3)
+				Throw_error(__FILE__, __LINE__, __func__, "Parameters must be 3D vectors");
+
+			result.vec.set_vec3(glm::cross(first.vec.to_vec3(), second.vec.to_vec3()));
+
+			return result;
+		case MIX_FN:
+
+			if (first.vec.get_num_dims() != second.vec.get_num_dims())
+				Throw_error(__FILE__, __LINE__, __func__, "Different dimension count at n-dimensional function");
+
+			if (third.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "Third parameter of function must be scalar value");
+
+			switch (first.vec.get_num_dims())
+			{
+			case 1:
+				result.vec.set_scalar(glm::mix(first.vec.to_scalar(), second.vec.to_scalar(), third.vec.to_scalar()));
+				break;
+			case 2:
+				result.vec.set_vec2(glm::mix(first.vec.to_vec2(), second.vec.to_vec2(), third.vec.to_scalar()));
+				break;
+			case 3:
+				result.vec.set_vec3(glm::mix(first.vec.to_vec3(), second.vec.to_vec3(), third.vec.to_scalar()));
+				break;
+			case 4:
+				result.vec.set_vec4(glm::mix(first.vec.to_vec4(), second.vec.to_vec4(), third.vec.to_scalar()));
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vector");
+			}
+
+			return result;
+		case MAT2_FN:
+			num_dims = first.mat.get_num_dims();
+			
+			if (!first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
+
+			switch (num_dims)
+			{
+			case 2:
+				result.mat.set_mat2(first.mat.to_mat2());
+				break;
+			case 3:
+				result.mat.set_mat2(first.mat.to_mat3());
+				break;
+			case 4:
+				result.mat.set_mat2(first.mat.to_mat4());
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
+			}
+
+			return result;
+		case MAT3_FN:
+			num_dims = first.mat.get_num_dims();
+
+			if (!first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
+
+			switch (num_dims)
+			{
+			case 2:
+				result.mat.set_mat3(first.mat.to_mat2());
+				break;
+			case 3:
+				result.mat.set_mat3(first.mat.to_mat3());
+				break;
+			case 4:
+				result.mat.set_mat3(first.mat.to_mat4());
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
+			}
+
+			return result;
+		case MAT4_FN:
+			num_dims = first.mat.get_num_dims();
+
+			if (!first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
+
+			switch (num_dims)
+			{
+			case 2:
+				result.mat.set_mat4(first.mat.to_mat2());
+				break;
+			case 3:
+				result.mat.set_mat4(first.mat.to_mat3());
+				break;
+			case 4:
+				result.mat.set_mat4(first.mat.to_mat4());
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong base of matrix");
+			}
+
+			return result;
+		case SCALE_FN:
+
+			if (!first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
+			if (second.is_mat() || second.vec.get_num_dims() != 3)
+				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be 3D vector");
+
+			result.mat.set_mat4(glm::scale((glm::mat4)first.mat.to_mat4(), (glm::vec3)second.vec.to_vec3()));
+
+			return result;
+		case ROTATE_FN:
+
+			if (!first.is_mat() || first.mat.get_num_dims() != 4)
+				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
+			if (second.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be scalar");
+			if (third.is_mat() || third.vec.get_num_dims() != 3)
+				Throw_error(__FILE__, __LINE__, __func__, "Third parameter must be 3D vector");
+
+			result.mat.set_mat4(glm::rotate(first.mat.to_mat4(), second.vec.to_scalar(), third.vec.to_vec3()));
+
+			return result;
+		case TRANSLATE_FN:
+
+			if (!first.is_mat() || first.mat.get_num_dims() != 4)
+				Throw_error(__FILE__, __LINE__, __func__, "First parameter must be 4x4 matrix");
+			if (second.is_mat() || second.vec.get_num_dims() != 3)
+				Throw_error(__FILE__, __LINE__, __func__, "Second parameter must be 3D vector");
+
+			result.mat.set_mat4(glm::translate(first.mat.to_mat4(), second.vec.to_vec3()));
+
+			return result;
+		case INVERSE_TRANSPOSE_FN:
+
+			if (!first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be matrix");
+
+			switch (first.vec.get_num_dims())
+			{
+			case 2:
+				result.mat.set_mat2(glm::inverseTranspose(first.mat.to_mat2()));
+				break;
+			case 3:
+				result.mat.set_mat3(glm::inverseTranspose(first.mat.to_mat3()));
+				break;
+			case 4:
+				result.mat.set_mat4(glm::inverseTranspose(first.mat.to_mat4()));
+				break;
+			default: Throw_error(__FILE__, __LINE__, __func__, "Wrong n-dimensional vectors");
+			}
+
+			return result;
+		case PERSPECTIVE_PROJ_FN:
+
+			if (first.is_mat() || second.is_mat() || third.is_mat() || fourth.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "None of the parameters can't be matrix");
+			if (first.vec.get_num_dims() != 1 ||
+				second.vec.get_num_dims() != 1 ||
+				third.vec.get_num_dims() != 1 ||
+				fourth.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "All parameters must be scalar");
+
+			result.mat.set_mat4(glm::perspective(
+				first.vec.to_scalar(),
+				second.vec.to_scalar(),
+				third.vec.to_scalar(),
+				fourth.vec.to_scalar()));
+
+			return result;
+		case ORTHO_PROJ_FN:
+
+			if (first.is_mat() || second.is_mat() || third.is_mat() || fourth.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "None of the parameters can't be matrix");
+			if (first.vec.get_num_dims() != 1 ||
+				second.vec.get_num_dims() != 1 ||
+				third.vec.get_num_dims() != 1 ||
+				fourth.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "All parameters must be scalar");
+
+			result.mat.set_mat4(glm::ortho(
+				first.vec.to_scalar(),
+				second.vec.to_scalar(),
+				third.vec.to_scalar(),
+				fourth.vec.to_scalar()));
+
+			return result;
+		case FACTORIAL:
+
+			if (first.is_mat() || first.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "Value must be scalar");
+
+			result.vec.set_scalar(Factorial(first.vec.to_scalar()));
+
+			return result;
+		case RAND_FN:
+
+			if (first.is_mat())
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter can't be matrix");
+			if (first.vec.get_num_dims() != 1)
+				Throw_error(__FILE__, __LINE__, __func__, "Parameter must be scalar");
+			if (rng == nullptr)
+				Throw_error(__FILE__, __LINE__, __func__, "Random generator isn't available");
+
+			result.vec.set_scalar(Random(first.vec.to_scalar(), *rng));
+
+			return result;
+		default:
+			Throw_error(__FILE__, __LINE__, __func__, "Unknown function: %d", func);
+		}
+
+		return result;
+	}
+
+}
@@ -1,27 +1,78 @@
-#ifndef OPERATIONS_H
-#define OPERATIONS_H
-
-#include "functions.h"
-#include "types.h"
-
-
-namespace Math_solver {
-
-	double Radians(double degrees);
-	double Degrees(double radians);
-	double RoundOff(double value, unsigned int precision);
-	double Factorial(double value);
-	double Random(double value);
-
-	std::string Format_number(double value, unsigned int precision);
-
-	value_t Do_vector(value_t value, double (*fnc)(double));
-	value_t Do_vector_scalar(value_t lvalue, value_t rvalue, double (*fnc)(double, double));
-	value_t Do_vector_vector(value_t lvalue, value_t rvalue, double (*fnc)(double, double));
-	value_t Do_matrix_scalar(value_t lvalue, value_t rvalue, double (*fnc)(double, double));
-
-	value_t Do_func(TokenType func, BaseNode* expression1, BaseNode* expression2, BaseNode* expression3, BaseNode* expression4);
-
-}
-
-#endif // !OPERATIONS_H
\ No newline at end of file
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "functions.h"
+#include "types.h"
+#include "random.h"
+#include "simd.h"
+
+
+namespace Math_solver {
+
+	double Radians(double degrees);
+	double Degrees(double radians);
+	double RoundOff(double value, unsigned int precision);
+	double Factorial(double value);
+	double Random(double value, RandomStream& rng);
+
+	// parses signed decimal, 0b, 0o or 0x literal in [text, end) without
+	// allocating; returns end of the literal, or nullptr if it is malformed
+	const char* Parse_number(const char* text, const char* end, double& value);
+
+	// exact powers of ten, as returned by pow(10, i)
+	constexpr double POWERS_OF_10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	constexpr unsigned int NUM_POWERS_OF_10 = sizeof(POWERS_OF_10) / sizeof(POWERS_OF_10[0]);
+
+	// rounds to "precision" decimals (at most six are shown), adds thousands
+	// separators and drops trailing zeroes; writes at most NUMBER_STR_SIZE
+	// characters to "buffer" without allocating, returns their count
+	size_t Format_number(double value, unsigned int precision, char* buffer);
+	std::string Format_number(double value, unsigned int precision);
+
+	template<typename F>
+	value_t Do_vector(const value_t& value, F fnc)
+	{
+		value_t result(glm::dvec4(0.0), value.vec.get_num_dims());
+
+		Simd_map(value.vec.data(), result.vec.data(), value.vec.get_num_dims(), fnc);
+
+		return result;
+	}
+
+	// element-wise operation on a vector or matrix "lvalue" and a scalar (or vector
+	// of the same size) "rvalue"; programs look the kernel of an operation up once
+	typedef value_t (*element_kernel_t)(const value_t& lvalue, const value_t& rvalue);
+
+	element_kernel_t Get_vector_scalar_kernel(ElementOp op);
+	element_kernel_t Get_vector_vector_kernel(ElementOp op);
+	element_kernel_t Get_matrix_scalar_kernel(ElementOp op);
+
+	value_t Do_vector_scalar(const value_t& lvalue, const value_t& rvalue, ElementOp op);
+	value_t Do_vector_vector(const value_t& lvalue, const value_t& rvalue, ElementOp op);
+	value_t Do_matrix_scalar(const value_t& lvalue, const value_t& rvalue, ElementOp op);
+
+	// operator on two scalars, same rules and errors as Do_oper
+	double Scalar_oper(char oper, double left, double right);
+
+	value_t Do_oper(char oper, const value_t& left, const value_t& right);
+
+	// shape of the result of Do_oper or Do_func for operands of known shapes,
+	// false if they would be rejected on every evaluation
+	bool Operator_shape(char oper, const shape_t& left, const shape_t& right, shape_t& result);
+	bool Function_shape(TokenType func, const shape_t* parameters, unsigned int num_parameters, shape_t& result);
+
+	double Do_component(const value_t& component);
+
+	typedef double (*scalar_function_t)(double);
+
+	// element function of "func" applied to a scalar, nullptr if "func" isn't one
+	scalar_function_t Scalar_function(TokenType func);
+
+	// "rng" may be null when the expression doesn't call rand()
+	value_t Do_func(TokenType func, const value_t& first, const value_t& second, const value_t& third, const value_t& fourth, RandomStream* rng);
+
+}
+
+#endif // !OPERATIONS_H
@@ -0,0 +1,63 @@
+#include "output.h"
+#include "expression.h"
+#include "error.h"
+
+#include <cstring>
+#include <vector>
+
+
+namespace Math_solver {
+
+	unsigned char Result_tag(const shape_t& shape)
+	{
+		if (!shape.is_known())
+			Throw_error(__FILE__, __LINE__, __func__, "Result shape is unknown");
+
+		return (unsigned char)(shape.num_dims | (shape.is_mat ? RESULT_MATRIX : 0));
+	}
+
+	size_t Write_result_record(const value_t& value, unsigned char* buffer)
+	{
+		double components[16];
+		unsigned int num_components = Store_value(value, components, 16);
+
+		buffer[0] = Result_tag(shape_t::of(value));
+
+		for (unsigned int i = 0; i < num_components; i++)
+			Write_little_endian(components[i], buffer + 1 + i * sizeof(double));
+
+		return 1 + num_components * sizeof(double);
+	}
+
+	void Write_result_columns(FILE* output, const shape_t& shape, const double* results, size_t num_rows, size_t stride)
+	{
+		unsigned char header[1 + sizeof(uint64_t)];
+		unsigned int num_components = shape.is_mat ? shape.num_dims * shape.num_dims : shape.num_dims;
+
+		if (num_components > stride)
+			Throw_error(__FILE__, __LINE__, __func__, "Result has %u components, rows hold %u", num_components, (unsigned int)stride);
+
+		header[0] = Result_tag(shape);
+		Write_little_endian((uint64_t)num_rows, header + 1);
+
+		fwrite(header, 1, sizeof(header), output);
+
+		// column by column, in blocks
+		const size_t BLOCK_ROWS = 4096;
+		std::vector<unsigned char> block(BLOCK_ROWS * sizeof(double));
+
+		for (unsigned int component = 0; component < num_components; component++)
+		{
+			for (size_t begin = 0; begin < num_rows; begin += BLOCK_ROWS)
+			{
+				size_t end = begin + BLOCK_ROWS < num_rows ? begin + BLOCK_ROWS : num_rows;
+
+				for (size_t row = begin; row < end; row++)
+					Write_little_endian(results[row * stride + component], block.data() + (row - begin) * sizeof(double));
+
+				fwrite(block.data(), sizeof(double), end - begin, output);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,61 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "types.h"
+
+
+namespace Math_solver {
+
+	// Binary results, read by tools without parsing text. A record is a tag
+	// byte followed by the components as little-endian doubles, matrices in
+	// column-major order:
+	//
+	//     tag = num_dims (1 scalar, 2..4 vector) | RESULT_MATRIX (2..4 matrix)
+	//
+	// An error is the tag RESULT_ERROR, a little-endian uint32 length and the
+	// message (not terminated).
+	const unsigned char RESULT_MATRIX = 0x10;
+	const unsigned char RESULT_ERROR = 0xFF;
+
+	// tag and 16 doubles of a 4x4 matrix
+	const size_t RESULT_RECORD_SIZE = 1 + 16 * sizeof(double);
+
+	unsigned char Result_tag(const shape_t& shape);
+
+	// writes the record of "value", returns its size
+	size_t Write_result_record(const value_t& value, unsigned char* buffer);
+
+	// Columnar results of evaluate_batch: the tag of "shape", the number of
+	// rows as a little-endian uint64, then one column of "num_rows" doubles
+	// per component - every column has the same fixed width. Row "i" is read
+	// from "results + i * stride", as written by evaluate_batch.
+	void Write_result_columns(FILE* output, const shape_t& shape, const double* results, size_t num_rows, size_t stride);
+
+	inline void Write_little_endian(uint32_t value, unsigned char* buffer)
+	{
+		for (unsigned int i = 0; i < 4; i++)
+			buffer[i] = (unsigned char)(value >> (8 * i));
+	}
+
+	inline void Write_little_endian(uint64_t value, unsigned char* buffer)
+	{
+		for (unsigned int i = 0; i < 8; i++)
+			buffer[i] = (unsigned char)(value >> (8 * i));
+	}
+
+	inline void Write_little_endian(double value, unsigned char* buffer)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		Write_little_endian(bits, buffer);
+	}
+
+}
+
+#endif // !OUTPUT_H
@@ -1,733 +1,790 @@
-#include "config.h"
-#include "parser.h"
-
-
-namespace Math_solver {
-
-	std::map<std::string, std::string> Parser::variables;
-
-	void Parser::AddCommonVariables()
-	{
-		variables["pi"] = std::to_string(M_PI);
-		variables["e"] = std::to_string(M_E);
-	}
-
-	void Parser::CheckVariables()
-	{
-		pWord_ = program_.c_str();
-		type_ = NONE;
-
-		while (type_ != END) {
-			const char* before = pWord_;
-
-			GetToken(true);
-
-			if (type_ == VARIABLE_ASSIGN) {
-				AssignVariable(word_);
-				break;
-			}
-
-			if (type_ == VARIABLE_SUBSTITUTION)
-				SubstituteVariable(word_, program_, before);
-		}
-
-		Print_info("Expression: %s", program_.c_str());
-	}
-
-	bool Parser::AssignVariable(std::string variableName)
-	{
-		while (*pWord_ && isspace(*pWord_))
-			++pWord_;
-
-		if (*pWord_ != 0) {
-			std::string variable_value = std::string((char*)pWord_, strlen(pWord_));
-
-			// avoid cyclic assignment
-			pWord_ = variable_value.c_str();
-			type_ = NONE;
-
-			while (type_ != END) {
-				const char* before = pWord_;
-
-				GetToken(true);
-
-				if (type_ == VARIABLE_SUBSTITUTION) {
-					if (word_ == variableName) {
-						Print_info("Cyclic assigment: %s", variable_value.c_str());
-						SubstituteVariable(variableName, variable_value, before);
-					}
-				}
-			}
-
-			pWord_ = program_.c_str();
-			type_ = VARIABLE_ASSIGN;
-			variables[variableName] = variable_value;
-
-			Print_info("VARIABLE_ASSIGNED(%s: %s)", variableName.c_str(), variable_value.c_str());
-
-			return true;
-		}
-		else
-			return false;
-	}
-
-	void Parser::SubstituteVariable(std::string variableName, std::string& program, const char* from)
-	{
-		std::string program_copy = program;
-
-		while (*from && isspace(*from))
-			++from;
-
-		if (*from != 0) {
-
-			size_t variable_length = variableName.length();
-			size_t index = from - program.c_str();
-
-			auto start = program_copy.begin() + index;
-			auto end = start + variable_length;
-			program_copy.replace(start, end, variables[variableName]);
-
-			Print_info("REPLACING: %s, %s", variableName.c_str(), variables[variableName].c_str());
-
-			program = program_copy;
-			pWord_ = program.c_str();
-			type_ = NONE;
-		}
-	}
-
-	void Parser::ExecuteOneParameterFunction(TokenType functionName)
-	{
-		BaseNode* first_par;
-
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		AddSubtract(true);
-		first_par = nodes.back();
-
-		CheckToken(RHPAREN);
-		GetToken(true);
-
-		nodes.push_back(new FuncNode(functionName, first_par));
-	}
-
-	void Parser::ExecuteTwoParameterFunction(TokenType functionName)
-	{
-		BaseNode* first_par, * second_par;
-
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		AddSubtract(true);
-		first_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		second_par = nodes.back();
-
-		CheckToken(RHPAREN);
-		GetToken(true);
-
-		nodes.push_back(new FuncNode(functionName, first_par, second_par));
-	}
-
-	void Parser::ExecuteThreeParameterFunction(TokenType functionName)
-	{
-		BaseNode* first_par, * second_par, * third_par;
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		AddSubtract(true);
-		first_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		second_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		third_par = nodes.back();
-
-		CheckToken(RHPAREN);
-		GetToken(true);
-
-		nodes.push_back(new FuncNode(functionName, first_par, second_par, third_par));
-	}
-
-	void Parser::ExecuteFourParameterFunction(TokenType functionName)
-	{
-		BaseNode* first_par, * second_par, * third_par, * fourth_par;
-
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		AddSubtract(true);
-		first_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		second_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		third_par = nodes.back();
-
-		CheckToken(COMMA);
-
-		AddSubtract(true);
-		fourth_par = nodes.back();
-
-		CheckToken(RHPAREN);
-		GetToken(true);
-
-		nodes.push_back(new FuncNode(functionName, first_par, second_par, third_par, fourth_par));
-	}
-
-	void Parser::CreateVector()
-	{
-		dim_row_index_ = 0;
-		filling_multi_ = true;
-
-		value_ = value_t(glm::dvec4(0), max_dim_);
-
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		do {
-			if (type_ == RHPAREN)
-				break;
-
-			AddSubtract(true); // GetToken ->AddSubtract(false) ->analyze "type_" !!!!!!
-		} while (type_ == COMMA);
-
-		nodes.push_back(new NumNode(value_));
-
-		filling_multi_ = false;
-		dim_row_index_ = 0;
-		max_dim_ = 1;
-		GetToken(true);
-	}
-
-	void Parser::CreateMatrix(TokenType t)
-	{
-		value_ = value_t(glm::dmat4(1.0), max_dim_); // Identity matrix
-
-		GetToken(true);
-		CheckToken(LHPAREN);
-
-		GetToken(true);
-		if (type_ == RHPAREN) { // no parameters
-			nodes.push_back(new NumNode(value_));
-		}
-		else { // got parameter
-			AddSubtract(false);
-			BaseNode* par = nodes.back();
-
-			nodes.push_back(new FuncNode(t, par));
-
-			CheckToken(RHPAREN);
-		}
-		max_dim_ = 1;
-		GetToken(true);
-	}
-
-	const TokenType Parser::GetToken(const bool ignoreSign)
-	{
-		word_.erase(0, std::string::npos);
-
-		while (*pWord_ && isspace(*pWord_))
-			++pWord_;
-
-		pWordStart_ = pWord_;
-
-		if (*pWord_ == 0 &&
-			type_ == END)
-			Throw_error(__FILE__, __LINE__, __func__, "Unexpected end of expression.");
-
-		unsigned char cFirstCharacter = *pWord_;
-
-		if (cFirstCharacter == 0)
-		{
-			word_ = "<End of expression>";
-
-			Print_info("END");
-
-			return type_ = END;
-		}
-
-		unsigned char cNextCharacter = *(pWord_ + 1);
-
-		if ((!ignoreSign &&
-			(cFirstCharacter == '+' || cFirstCharacter == '-') &&
-			(isdigit(cNextCharacter) || cNextCharacter == '.')
-			)
-			|| isdigit(cFirstCharacter)
-			|| (cFirstCharacter == '.' && isdigit(cNextCharacter)))
-		{
-			if ((cFirstCharacter == '+' || cFirstCharacter == '-'))
-				pWord_++;
-
-			while (isdigit(*pWord_) || *pWord_ == '.')
-				pWord_++;
-
-			word_ = std::string(pWordStart_, pWord_ - pWordStart_);
-
-			std::istringstream is(word_);
-
-			is >> value_temp_[dim_row_index_];
-			value_ = value_t(value_temp_, max_dim_);
-
-			if (is.fail() || !is.eof())
-				Throw_error(__FILE__, __LINE__, __func__, "Bad numeric literal: %s", word_.c_str());
-
-			Print_info("SCALAR (%.1f) [%d]", value_.vec.to_vec4()[dim_row_index_], dim_row_index_);
-
-			return type_ = SCALAR;
-		}
-
-		switch (cFirstCharacter)
-		{
-		case '+':
-		case '-':
-		case '*':
-		case '/':
-		case '%':
-		case '!':
-		case '^':
-		case '(':
-		case ')':
-		case ',':
-			word_ = std::string(pWordStart_, 1);
-			++pWord_;
-
-			Print_info("%c", cFirstCharacter);
-
-			return type_ = TokenType(cFirstCharacter);
-		}
-
-		if (!isalpha(cFirstCharacter))
-		{
-			if (cFirstCharacter < ' ')
-			{
-				std::ostringstream s;
-				s << "Unexpected character (decimal " << int(cFirstCharacter) << ")";
-				Throw_error(__FILE__, __LINE__, __func__, s.str().c_str());
-			}
-			else
-				Throw_error(__FILE__, __LINE__, __func__, "Unexpected character: %c", cFirstCharacter);
-		}
-		else {
-
-			pWord_ = pWordStart_;
-
-			while (*pWord_ && (isalnum(*pWord_) || (*pWord_ == '_')))
-				++pWord_;
-
-			word_ = std::string(pWordStart_, pWord_ - pWordStart_);
-
-			// check functions
-			TokenType t;
-			if ((t = CheckFunction(word_)) != TokenType(NONE))
-				return type_ = t;
-
-			// check variables
-			std::string variable_name = word_;
-
-			while (*pWord_ && isspace(*pWord_))
-				++pWord_;
-
-			if (*pWord_ == '=') {// assignment
-				++pWord_;
-				return type_ = TokenType(VARIABLE_ASSIGN);
-			}
-
-			auto search = variables.find(variable_name);
-			if (search != variables.end())  // substitution
-				return type_ = TokenType(VARIABLE_SUBSTITUTION);
-
-			Throw_error(__FILE__, __LINE__, __func__, "Unexpected alphanumeric characters: %s", word_.c_str());
-		}
-
-		return TokenType::NONE;
-	}
-
-	void Parser::Primary(const bool get)
-	{
-		if (get)
-			GetToken();
-
-		switch (type_)
-		{
-		case SCALAR:
-		{
-			if (!filling_multi_)
-			{
-				nodes.push_back(new NumNode(value_));
-				GetToken(true);
-			}
-			else
-				AddSubtract(true);
-			break;
-		}
-		case MINUS:
-		{
-			break;
-		}
-		case COMMA:
-		{
-			if (filling_multi_)
-			{
-				++dim_row_index_;
-				if (dim_row_index_ == max_dim_)
-					Throw_error(__FILE__, __LINE__, __func__, "Too much dimensions");
-			}
-			else
-				Throw_error(__FILE__, __LINE__, __func__, "Unexpected character: \",\"");
-			break;
-		}
-		case LHPAREN:
-		{
-			AddSubtract(true);
-			CheckToken(RHPAREN);
-			GetToken(true);
-			break;
-		}
-		case RHPAREN:
-		{
-			break;
-		}
-		case RAD_FN:
-		{
-			ExecuteOneParameterFunction(RAD_FN);
-			break;
-		}
-		case DEG_FN:
-		{
-			ExecuteOneParameterFunction(DEG_FN);
-			break;
-		}
-		case SIN_FN:
-		{
-			ExecuteOneParameterFunction(SIN_FN);
-			break;
-		}
-		case COS_FN:
-		{
-			ExecuteOneParameterFunction(COS_FN);
-			break;
-		}
-		case TAN_FN:
-		{
-			ExecuteOneParameterFunction(TAN_FN);
-			break;
-		}
-		case SINH_FN:
-		{
-			ExecuteOneParameterFunction(SINH_FN);
-			break;
-		}
-		case COSH_FN:
-		{
-			ExecuteOneParameterFunction(COSH_FN);
-			break;
-		}
-		case TANH_FN:
-		{
-			ExecuteOneParameterFunction(TANH_FN);
-			break;
-		}
-		case ASIN_FN:
-		{
-			ExecuteOneParameterFunction(ASIN_FN);
-			break;
-		}
-		case ACOS_FN:
-		{
-			ExecuteOneParameterFunction(ACOS_FN);
-			break;
-		}
-		case ATAN_FN:
-		{
-			ExecuteOneParameterFunction(ATAN_FN);
-			break;
-		}
-		case ABS_FN:
-		{
-			ExecuteOneParameterFunction(ABS_FN);
-			break;
-		}
-		case LN_FN:
-		{
-			ExecuteOneParameterFunction(LN_FN);
-			break;
-		}
-		case LOG_FN:
-		{
-			ExecuteOneParameterFunction(LOG_FN);
-			break;
-		}
-		case EXP_FN:
-		{
-			ExecuteOneParameterFunction(EXP_FN);
-			break;
-		}
-		case SQRT_FN:
-		{
-			ExecuteOneParameterFunction(SQRT_FN);
-			break;
-		}
-		case VEC2_FN:
-		{
-			max_dim_ = 2;
-			CreateVector();
-			break;
-		}
-		case VEC3_FN:
-		{
-			max_dim_ = 3;
-			CreateVector();
-			break;
-		}
-		case VEC4_FN:
-		{
-			max_dim_ = 4;
-			CreateVector();
-			break;
-		}
-		case MAT2_FN:
-		{
-			max_dim_ = 2;
-			CreateMatrix(MAT2_FN);
-			break;
-		}
-		case MAT3_FN:
-		{
-			max_dim_ = 3;
-			CreateMatrix(MAT3_FN);
-			break;
-		}
-		case MAT4_FN:
-		{
-			max_dim_ = 4;
-			CreateMatrix(MAT4_FN);
-			break;
-		}
-		case LENGTH_FN:
-		{
-			ExecuteOneParameterFunction(LENGTH_FN);
-			break;
-		}
-		case NORMALIZE_FN:
-		{
-			ExecuteOneParameterFunction(NORMALIZE_FN);
-			break;
-		}
-		case DOT_PRODUCT_FN:
-		{
-			ExecuteTwoParameterFunction(DOT_PRODUCT_FN);
-			break;
-		}
-		case CROSS_PRODUCT_FN:
-		{
-			ExecuteTwoParameterFunction(CROSS_PRODUCT_FN);
-			break;
-		}
-		case MIX_FN:
-		{
-			ExecuteThreeParameterFunction(MIX_FN);
-			break;
-		}
-		case SCALE_FN:
-		{
-			ExecuteTwoParameterFunction(SCALE_FN);
-			break;
-		}
-		case ROTATE_FN:
-		{
-			ExecuteThreeParameterFunction(ROTATE_FN);
-			break;
-		}
-		case TRANSLATE_FN:
-		{
-			ExecuteTwoParameterFunction(TRANSLATE_FN);
-			break;
-		}
-		case INVERSE_TRANSPOSE_FN:
-		{
-			ExecuteOneParameterFunction(INVERSE_TRANSPOSE_FN);
-			break;
-		}
-		case PERSPECTIVE_PROJ_FN:
-		{
-			ExecuteFourParameterFunction(PERSPECTIVE_PROJ_FN);
-			break;
-		}
-		case ORTHO_PROJ_FN:
-		{
-			ExecuteFourParameterFunction(ORTHO_PROJ_FN);
-			break;
-		}
-		case RAND_FN:
-		{
-			ExecuteOneParameterFunction(RAND_FN);
-			break;
-		}
-		default:
-			Throw_error(__FILE__, __LINE__, __func__, "Unexpected token: %s", word_.c_str());
-		}
-	}
-
-	void Parser::Power(const bool get)
-	{
-		Primary(get);
-
-		while (true)
-		{
-			switch (type_)
-			{
-			case POW:
-			{
-				BaseNode* temp = nodes.back();
-				Primary(true);
-				nodes.push_back(new OperNode('^', temp, nodes.back()));
-				break;
-			}
-
-			case FACTORIAL:
-			{
-				value_t par = nodes.back()->value();
-
-				if (!par.is_mat() && par.vec.get_num_dims() == 1) // scalar
-				{
-					value_t result;
-
-					result.vec.set_scalar(Factorial(par.vec.to_scalar()));
-					nodes.push_back(new NumNode(result));
-					GetToken(true);
-				}
-				else
-					Throw_error(__FILE__, __LINE__, __func__, "Value must be scalar");
-
-				break;
-			}
-
-			default:
-				return;
-			}
-		}
-	}
-
-	void Parser::Term(const bool get)
-	{
-		Power(get);
-
-		while (true)
-		{
-			switch (type_)
-			{
-			case MULTIPLY:
-			{
-				BaseNode* temp = nodes.back();
-				Power(true); // get the next value...
-				nodes.push_back(new OperNode('*', temp, nodes.back()));
-				break;
-			}
-
-			case DIVIDE:
-			{
-				BaseNode* temp = nodes.back();
-				Power(true);
-
-				if (nodes.back()->value().vec.to_vec4()[0] == 0.0)
-					Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
-
-				nodes.push_back(new OperNode('/', temp, nodes.back()));
-				break;
-			}
-
-			case MODULO:
-			{
-				BaseNode* temp = nodes.back();
-				Power(true); // get the next value...
-				nodes.push_back(new OperNode('%', temp, nodes.back()));
-				break;
-			}
-
-			default:
-				return;
-			}
-		}
-	}
-
-	void Parser::AddSubtract(const bool get)
-	{
-		Term(get);
-
-		while (true)
-		{
-			switch (type_)
-			{
-			case PLUS:
-			{
-				BaseNode* temp = nodes.back();
-				Term(true);
-				nodes.push_back(new OperNode('+', temp, nodes.back()));
-				break;
-			}
-
-			case MINUS:
-			{
-				BaseNode* temp = nodes.back();
-				Term(true);
-				nodes.push_back(new OperNode('-', temp, nodes.back()));
-				break;
-			}
-
-			default:
-				return;
-			}
-		}
-	}
-
-	const value_t Parser::Evaluate()
-	{
-		// substitute variables
-		CheckVariables();
-
-		if (type_ == VARIABLE_ASSIGN) {
-			is_result_ = false;
-			return value_t();
-		}
-
-		pWord_ = program_.c_str();
-		type_ = NONE;
-
-		dim_row_index_ = 0;
-
-		max_dim_ = 1;
-		filling_multi_ = false;
-
-		// solve expression
-		AddSubtract(true);
-
-		if (type_ != END)
-			Throw_error(__FILE__, __LINE__, __func__, "Unexpected text at the end of expression: %s", pWordStart_);
-
-		is_result_ = true;
-		return nodes.back()->value();
-	}
-
-	const value_t Parser::Evaluate(const std::string& program)
-	{
-		program_ = program;
-		nodes.clear();
-
-		return Evaluate();
-	}
-
+#include "config.h"
+#include "parser.h"
+
+
+namespace Math_solver {
+
+
+	void Parser::ExecuteOneParameterFunction(TokenType functionName)
+	{
+		BaseNode* first_par;
+
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		AddSubtract(true);
+		first_par = nodes.back();
+
+		CheckToken(RHPAREN);
+		GetToken(true);
+
+		nodes.push_back(arena_.create<FuncNode>(functionName, first_par));
+	}
+
+	void Parser::ExecuteTwoParameterFunction(TokenType functionName)
+	{
+		BaseNode* first_par, * second_par;
+
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		AddSubtract(true);
+		first_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		second_par = nodes.back();
+
+		CheckToken(RHPAREN);
+		GetToken(true);
+
+		nodes.push_back(arena_.create<FuncNode>(functionName, first_par, second_par));
+	}
+
+	void Parser::ExecuteThreeParameterFunction(TokenType functionName)
+	{
+		BaseNode* first_par, * second_par, * third_par;
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		AddSubtract(true);
+		first_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		second_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		third_par = nodes.back();
+
+		CheckToken(RHPAREN);
+		GetToken(true);
+
+		nodes.push_back(arena_.create<FuncNode>(functionName, first_par, second_par, third_par));
+	}
+
+	void Parser::ExecuteFourParameterFunction(TokenType functionName)
+	{
+		BaseNode* first_par, * second_par, * third_par, * fourth_par;
+
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		AddSubtract(true);
+		first_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		second_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		third_par = nodes.back();
+
+		CheckToken(COMMA);
+
+		AddSubtract(true);
+		fourth_par = nodes.back();
+
+		CheckToken(RHPAREN);
+		GetToken(true);
+
+		nodes.push_back(arena_.create<FuncNode>(functionName, first_par, second_par, third_par, fourth_par));
+	}
+
+	void Parser::CreateVector(TokenType t, unsigned int num_dims)
+	{
+		BaseNode* components[4] = { nullptr, nullptr, nullptr, nullptr };
+		unsigned int num_components = 0;
+
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		GetToken();
+		if (type_ != RHPAREN) {
+			AddSubtract(false);
+			components[num_components++] = nodes.back();
+
+			while (type_ == COMMA) {
+				if (num_components == num_dims)
+					Throw_error(__FILE__, __LINE__, __func__, "Too much dimensions");
+
+				AddSubtract(true);
+				components[num_components++] = nodes.back();
+			}
+
+			CheckToken(RHPAREN);
+		}
+		GetToken(true);
+
+		nodes.push_back(arena_.create<FuncNode>(t, components[0], components[1], components[2], components[3]));
+	}
+
+	void Parser::CreateMatrix(TokenType t, unsigned int num_dims)
+	{
+		value_ = value_t(glm::dmat4(1.0), num_dims); // Identity matrix
+
+		GetToken(true);
+		CheckToken(LHPAREN);
+
+		GetToken(true);
+		if (type_ == RHPAREN) { // no parameters
+			nodes.push_back(arena_.create<NumNode>(value_));
+		}
+		else { // got parameter
+			AddSubtract(false);
+			BaseNode* par = nodes.back();
+
+			nodes.push_back(arena_.create<FuncNode>(t, par));
+
+			CheckToken(RHPAREN);
+		}
+		GetToken(true);
+	}
+
+	const TokenType Parser::GetToken(const bool ignoreSign)
+	{
+		word_ = std::string_view();
+
+		SkipSpaces();
+
+		pWordStart_ = pWord_;
+
+		if (IsAtEnd() &&
+			type_ == END)
+			Throw_error(__FILE__, __LINE__, __func__, "Unexpected end of expression.");
+
+		if (IsAtEnd())
+		{
+			word_ = "<End of expression>";
+
+			Print_info("END");
+
+			return type_ = END;
+		}
+
+		num_tokens_++;
+
+		unsigned char cFirstCharacter = *pWord_;
+		unsigned char cNextCharacter = (pWord_ + 1 != pEnd_) ? *(pWord_ + 1) : 0;
+
+		if ((!ignoreSign &&
+			(cFirstCharacter == '+' || cFirstCharacter == '-') &&
+			(isdigit(cNextCharacter) || cNextCharacter == '.')
+			)
+			|| isdigit(cFirstCharacter)
+			|| (cFirstCharacter == '.' && isdigit(cNextCharacter)))
+		{
+			double number;
+
+			// parsed in place, no token string
+			pWord_ = Parse_number(pWordStart_, pEnd_, number);
+
+			if (pWord_ == nullptr)
+			{
+				const char* pWordEnd = pWordStart_ + 1;
+
+				while (pWordEnd != pEnd_ && (isalnum((unsigned char)*pWordEnd) || *pWordEnd == '.'))
+					++pWordEnd;
+
+				Throw_error(__FILE__, __LINE__, __func__, "Bad numeric literal: %.*s%s", Quoted_length(pWordEnd - pWordStart_), pWordStart_, Quoted_ellipsis(pWordEnd - pWordStart_));
+			}
+
+			word_ = std::string_view(pWordStart_, pWord_ - pWordStart_);
+			value_ = value_t(glm::dvec4(number));
+
+			Print_info("SCALAR (%.1f)", number);
+
+			return type_ = SCALAR;
+		}
+
+		switch (cFirstCharacter)
+		{
+		case '+':
+		case '-':
+		case '*':
+		case '/':
+		case '%':
+		case '!':
+		case '^':
+		case '(':
+		case ')':
+		case ',':
+			word_ = std::string_view(pWordStart_, 1);
+			++pWord_;
+
+			Print_info("%c", cFirstCharacter);
+
+			return type_ = TokenType(cFirstCharacter);
+		}
+
+		if (!isalpha(cFirstCharacter))
+		{
+			if (cFirstCharacter < ' ')
+			{
+				std::ostringstream s;
+				s << "Unexpected character (decimal " << int(cFirstCharacter) << ")";
+				Throw_error(__FILE__, __LINE__, __func__, s.str().c_str());
+			}
+			else
+				Throw_error(__FILE__, __LINE__, __func__, "Unexpected character: %c", cFirstCharacter);
+		}
+		else {
+
+			pWord_ = pWordStart_;
+
+			while (pWord_ != pEnd_ && (isalnum((unsigned char)*pWord_) || (*pWord_ == '_')))
+				++pWord_;
+
+			word_ = std::string_view(pWordStart_, pWord_ - pWordStart_);
+
+			// check functions
+			TokenType t;
+			if ((t = CheckFunction(word_)) != TokenType(NONE))
+				return type_ = t;
+
+			// check variables
+			SkipSpaces();
+
+			bool is_assignment = (!IsAtEnd() && *pWord_ == '=');
+
+			// check constants
+			double constant;
+			if (CheckConstant(word_, constant)) {
+				if (is_assignment)
+					Throw_error(__FILE__, __LINE__, __func__, "Constant can't be assigned: %.*s%s", Quoted_length(word_.size()), word_.data(), Quoted_ellipsis(word_.size()));
+
+				value_ = value_t(glm::dvec4(constant));
+				return type_ = SCALAR;
+			}
+
+			if (is_assignment) {
+				++pWord_;
+				return type_ = TokenType(VARIABLE_ASSIGN);
+			}
+
+			for (unsigned int i = 0; i < parameters_.size(); i++) {
+				if (parameters_[i] == word_) { // bound at evaluation
+					parameter_index_ = i;
+					num_names_resolved_++;
+					return type_ = TokenType(VARIABLE_PARAMETER);
+				}
+			}
+
+			if (context_.get_variables().find(word_, variable_index_)) { // resolved to slot
+				num_names_resolved_++;
+				return type_ = TokenType(VARIABLE_REFERENCE);
+			}
+
+			Throw_error(__FILE__, __LINE__, __func__, "Unexpected alphanumeric characters: %.*s%s", Quoted_length(word_.size()), word_.data(), Quoted_ellipsis(word_.size()));
+		}
+
+		return TokenType::NONE;
+	}
+
+	// pushes exactly one node (the operand) or throws, callers take it by nodes.back()
+	void Parser::Primary(const bool get)
+	{
+		if (get)
+			GetToken();
+
+		switch (type_)
+		{
+		case SCALAR:
+		{
+			nodes.push_back(arena_.create<NumNode>(value_));
+			GetToken(true);
+			break;
+		}
+		case VARIABLE_REFERENCE:
+		{
+			nodes.push_back(arena_.create<VarNode>(context_.get_variables().get_slots(), variable_index_));
+			GetToken(true);
+			break;
+		}
+		case VARIABLE_PARAMETER:
+		{
+			nodes.push_back(arena_.create<ParamNode>(parameter_index_));
+			GetToken(true);
+			break;
+		}
+		case MINUS: // sign of anything but a number, binds like the sign of a number: -a^2 is (-a)^2
+		{
+			if (++depth_ > MAX_NESTING_DEPTH)
+				Throw_error(__FILE__, __LINE__, __func__, "Expression is nested deeper than %d levels", MAX_NESTING_DEPTH);
+
+			BaseNode* sign = arena_.create<NumNode>(value_t(-1.0));
+			nodes.push_back(sign);
+
+			Primary(true);
+			nodes.push_back(arena_.create<OperNode>('*', sign, nodes.back()));
+			depth_--;
+			break;
+		}
+		case COMMA:
+		{
+			Throw_error(__FILE__, __LINE__, __func__, "Unexpected character: \",\"");
+			break;
+		}
+		case LHPAREN:
+		{
+			AddSubtract(true);
+			CheckToken(RHPAREN);
+			GetToken(true);
+			break;
+		}
+		case RHPAREN:
+		{
+			Throw_error(__FILE__, __LINE__, __func__, "Missing operand before \")\"");
+			break;
+		}
+		case RAD_FN:
+		{
+			ExecuteOneParameterFunction(RAD_FN);
+			break;
+		}
+		case DEG_FN:
+		{
+			ExecuteOneParameterFunction(DEG_FN);
+			break;
+		}
+		case SIN_FN:
+		{
+			ExecuteOneParameterFunction(SIN_FN);
+			break;
+		}
+		case COS_FN:
+		{
+			ExecuteOneParameterFunction(COS_FN);
+			break;
+		}
+		case TAN_FN:
+		{
+			ExecuteOneParameterFunction(TAN_FN);
+			break;
+		}
+		case SINH_FN:
+		{
+			ExecuteOneParameterFunction(SINH_FN);
+			break;
+		}
+		case COSH_FN:
+		{
+			ExecuteOneParameterFunction(COSH_FN);
+			break;
+		}
+		case TANH_FN:
+		{
+			ExecuteOneParameterFunction(TANH_FN);
+			break;
+		}
+		case ASIN_FN:
+		{
+			ExecuteOneParameterFunction(ASIN_FN);
+			break;
+		}
+		case ACOS_FN:
+		{
+			ExecuteOneParameterFunction(ACOS_FN);
+			break;
+		}
+		case ATAN_FN:
+		{
+			ExecuteOneParameterFunction(ATAN_FN);
+			break;
+		}
+		case ABS_FN:
+		{
+			ExecuteOneParameterFunction(ABS_FN);
+			break;
+		}
+		case LN_FN:
+		{
+			ExecuteOneParameterFunction(LN_FN);
+			break;
+		}
+		case LOG_FN:
+		{
+			ExecuteOneParameterFunction(LOG_FN);
+			break;
+		}
+		case EXP_FN:
+		{
+			ExecuteOneParameterFunction(EXP_FN);
+			break;
+		}
+		case SQRT_FN:
+		{
+			ExecuteOneParameterFunction(SQRT_FN);
+			break;
+		}
+		case VEC2_FN:
+		{
+			CreateVector(VEC2_FN, 2);
+			break;
+		}
+		case VEC3_FN:
+		{
+			CreateVector(VEC3_FN, 3);
+			break;
+		}
+		case VEC4_FN:
+		{
+			CreateVector(VEC4_FN, 4);
+			break;
+		}
+		case MAT2_FN:
+		{
+			CreateMatrix(MAT2_FN, 2);
+			break;
+		}
+		case MAT3_FN:
+		{
+			CreateMatrix(MAT3_FN, 3);
+			break;
+		}
+		case MAT4_FN:
+		{
+			CreateMatrix(MAT4_FN, 4);
+			break;
+		}
+		case LENGTH_FN:
+		{
+			ExecuteOneParameterFunction(LENGTH_FN);
+			break;
+		}
+		case NORMALIZE_FN:
+		{
+			ExecuteOneParameterFunction(NORMALIZE_FN);
+			break;
+		}
+		case DOT_PRODUCT_FN:
+		{
+			ExecuteTwoParameterFunction(DOT_PRODUCT_FN);
+			break;
+		}
+		case CROSS_PRODUCT_FN:
+		{
+			ExecuteTwoParameterFunction(CROSS_PRODUCT_FN);
+			break;
+		}
+		case MIX_FN:
+		{
+			ExecuteThreeParameterFunction(MIX_FN);
+			break;
+		}
+		case SCALE_FN:
+		{
+			ExecuteTwoParameterFunction(SCALE_FN);
+			break;
+		}
+		case ROTATE_FN:
+		{
+			ExecuteThreeParameterFunction(ROTATE_FN);
+			break;
+		}
+		case TRANSLATE_FN:
+		{
+			ExecuteTwoParameterFunction(TRANSLATE_FN);
+			break;
+		}
+		case INVERSE_TRANSPOSE_FN:
+		{
+			ExecuteOneParameterFunction(INVERSE_TRANSPOSE_FN);
+			break;
+		}
+		case PERSPECTIVE_PROJ_FN:
+		{
+			ExecuteFourParameterFunction(PERSPECTIVE_PROJ_FN);
+			break;
+		}
+		case ORTHO_PROJ_FN:
+		{
+			ExecuteFourParameterFunction(ORTHO_PROJ_FN);
+			break;
+		}
+		case RAND_FN:
+		{
+			ExecuteOneParameterFunction(RAND_FN);
+			break;
+		}
+		default:
+			Throw_error(__FILE__, __LINE__, __func__, "Unexpected token: %.*s%s", Quoted_length(word_.size()), word_.data(), Quoted_ellipsis(word_.size()));
+		}
+	}
+
+	void Parser::Power(const bool get)
+	{
+		Primary(get);
+
+		while (true)
+		{
+			switch (type_)
+			{
+			case POW:
+			{
+				BaseNode* temp = nodes.back();
+				Primary(true);
+				nodes.push_back(arena_.create<OperNode>('^', temp, nodes.back()));
+				break;
+			}
+
+			case FACTORIAL:
+			{
+				BaseNode* par = nodes.back();
+				nodes.push_back(arena_.create<FuncNode>(FACTORIAL, par));
+				GetToken(true);
+				break;
+			}
+
+			default:
+				return;
+			}
+		}
+	}
+
+	void Parser::Term(const bool get)
+	{
+		Power(get);
+
+		while (true)
+		{
+			switch (type_)
+			{
+			case MULTIPLY:
+			{
+				BaseNode* temp = nodes.back();
+				Power(true); // get the next value...
+				nodes.push_back(arena_.create<OperNode>('*', temp, nodes.back()));
+				break;
+			}
+
+			case DIVIDE:
+			{
+				BaseNode* temp = nodes.back();
+				Power(true);
+				nodes.push_back(arena_.create<OperNode>('/', temp, nodes.back()));
+				break;
+			}
+
+			case MODULO:
+			{
+				BaseNode* temp = nodes.back();
+				Power(true); // get the next value...
+				nodes.push_back(arena_.create<OperNode>('%', temp, nodes.back()));
+				break;
+			}
+
+			default:
+				return;
+			}
+		}
+	}
+
+	void Parser::AddSubtract(const bool get)
+	{
+		if (++depth_ > MAX_NESTING_DEPTH)
+			Throw_error(__FILE__, __LINE__, __func__, "Expression is nested deeper than %d levels", MAX_NESTING_DEPTH);
+
+		Term(get);
+
+		while (true)
+		{
+			switch (type_)
+			{
+			case PLUS:
+			{
+				BaseNode* temp = nodes.back();
+				Term(true);
+				nodes.push_back(arena_.create<OperNode>('+', temp, nodes.back()));
+				break;
+			}
+
+			case MINUS:
+			{
+				BaseNode* temp = nodes.back();
+				Term(true);
+				nodes.push_back(arena_.create<OperNode>('-', temp, nodes.back()));
+				break;
+			}
+
+			default:
+				depth_--;
+				return;
+			}
+		}
+	}
+
+	CompiledExpression Parser::Compile(const std::vector<std::string>& parameters, const std::vector<shape_t>& parameter_shapes)
+	{
+		PhaseTimer timer(context_.get_metrics());
+
+		try
+		{
+			CompiledExpression expression = Build(parameters, parameter_shapes, true);
+
+			timer.lap(PHASE_PARSE);
+			return expression;
+		}
+		catch (...)
+		{
+			UpdateMetrics(true);
+			throw;
+		}
+	}
+
+	CompiledExpression Parser::Build(const std::vector<std::string>& parameters, const std::vector<shape_t>& parameter_shapes, bool is_native)
+	{
+		CompiledExpression expression;
+
+		// tree of previous compilation isn't needed any more
+		nodes.clear();
+		arena_.reset();
+
+		parameters_ = parameters;
+		depth_ = 0;
+		num_tokens_ = 0;
+		num_names_resolved_ = 0;
+
+		expression.num_parameters_ = (unsigned int)parameters_.size();
+
+		pWord_ = source_.data();
+		pEnd_ = source_.data() + source_.size();
+		type_ = NONE;
+
+		GetToken();
+
+		if (type_ == VARIABLE_ASSIGN) {
+			std::string_view variable_name = word_;
+
+			AddSubtract(true);
+
+			if (type_ != END)
+				Throw_error(__FILE__, __LINE__, __func__, "Unexpected text at the end of expression: %.*s%s", Quoted_length(pEnd_ - pWordStart_), pWordStart_, Quoted_ellipsis(pEnd_ - pWordStart_));
+
+			// slot is created only for successfully parsed assignment
+			unsigned int index = context_.get_variables().add(variable_name);
+			nodes.push_back(arena_.create<AssignNode>(context_.get_variables().get_slots(), index, nodes.back()));
+
+			Print_info("VARIABLE_ASSIGN(%.*s%s)", Quoted_length(variable_name.size()), variable_name.data(), Quoted_ellipsis(variable_name.size()));
+
+			is_result_ = false;
+		}
+		else {
+			// build expression tree
+			AddSubtract(false);
+
+			if (type_ != END)
+				Throw_error(__FILE__, __LINE__, __func__, "Unexpected text at the end of expression: %.*s%s", Quoted_length(pEnd_ - pWordStart_), pWordStart_, Quoted_ellipsis(pEnd_ - pWordStart_));
+
+			is_result_ = true;
+		}
+
+		// folding and lowering recurse as deep as the tree, long chains of operators would overflow the stack
+		if (nodes.back()->height() > MAX_TREE_HEIGHT)
+			Throw_error(__FILE__, __LINE__, __func__, "Expression is too long, %u levels of operators (at most %d)", nodes.back()->height(), MAX_TREE_HEIGHT);
+
+		// collapse constant subtrees
+		BaseNode* root = nodes.back()->fold(arena_);
+
+		// lower tree to bytecode, the tree is only front-end representation
+		// shapes are inferred (and shape errors reported) while emitting
+		std::shared_ptr<Program> program = std::make_shared<Program>();
+		program->set_parameter_shapes(parameter_shapes);
+		root->emit(*program);
+		program->finish(is_native);
+
+		expression.program_ = program;
+		expression.context_ = &context_;
+		expression.is_result_ = is_result_;
+		UpdateMetrics(false);
+
+		return expression;
+	}
+
+	unsigned int Parser::Lex()
+	{
+		pWord_ = source_.data();
+		pEnd_ = source_.data() + source_.size();
+		type_ = NONE;
+
+		num_tokens_ = 0;
+		num_names_resolved_ = 0;
+
+		bool is_operand = false; // sign after an operand is an operator
+
+		while (GetToken(is_operand) != END)
+			is_operand = (type_ == SCALAR || type_ == VARIABLE_REFERENCE || type_ == VARIABLE_PARAMETER || type_ == RHPAREN || type_ == FACTORIAL);
+
+		unsigned int num_tokens = num_tokens_;
+		UpdateMetrics(false);
+
+		return num_tokens;
+	}
+
+	const value_t Parser::Evaluate()
+	{
+		PhaseTimer timer(context_.get_metrics());
+		CompiledExpression expression;
+
+		try
+		{
+			expression = Build(std::vector<std::string>(), std::vector<shape_t>(), false); // evaluated once
+		}
+		catch (...)
+		{
+			UpdateMetrics(true);
+			throw;
+		}
+
+		timer.lap(PHASE_PARSE);
+
+		value_t result = expression.evaluate();
+
+		timer.lap(PHASE_EVALUATE);
+		return result;
+	}
+
+	void Parser::UpdateMetrics(bool is_failed)
+	{
+		Metrics& metrics = context_.get_metrics();
+
+		metrics.add_tokens(num_tokens_);
+		metrics.add_names_resolved(num_names_resolved_);
+
+		for (const BaseNode* node : arena_.get_nodes())
+			metrics.add_node(node->token());
+
+		arena_.clear_nodes();
+
+		if (is_failed)
+			metrics.add_exception();
+
+		num_tokens_ = 0;
+		num_names_resolved_ = 0;
+		nodes.clear();
+	}
+
+	const value_t Parser::Evaluate(const std::string& program)
+	{
+		program_ = program;
+		source_ = program_;
+
+		return Evaluate();
+	}
+
+	const value_t Parser::Evaluate(const char* source, size_t length)
+	{
+		program_.clear();
+		source_ = std::string_view(source, length);
+
+		return Evaluate();
+	}
+
 }
\ No newline at end of file
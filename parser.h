@@ -1,89 +1,138 @@
-#ifndef PARSER_H
-#define PARSER_H
-
-#include <sstream>
-#include <vector>
-#include <map>
-#include <iostream>
-#include <iomanip>
-
-#include "constants.h"
-#include "operations.h"
-#include "functions.h"
-#include "types.h"
-#include "error.h"
-
-
-namespace Math_solver {
-
-	class Parser
-	{
-
-	private:
-		std::string program_;
-
-		const char* pWord_;
-		const char* pWordStart_;
-
-		unsigned int dim_row_index_;
-		unsigned int max_dim_;
-
-		bool filling_multi_;
-
-		TokenType type_;
-		std::string word_;
-		value_t value_;
-		glm::dvec4 value_temp_;
-
-		std::vector<BaseNode*> nodes;
-
-		static std::map<std::string, std::string> variables;
-
-		bool is_result_;
-
-	public:
-		Parser(const std::string& program)
-			: program_(program)
-		{
-			AddCommonVariables();
-		}
-
-		const value_t Evaluate();
-		const value_t Evaluate(const std::string& program);
-
-		bool IsResult() const { return is_result_; }
-
-	private:
-		void AddCommonVariables();
-
-		void CheckVariables();
-		bool AssignVariable(std::string variableName);
-		void SubstituteVariable(std::string variableName, std::string& program, const char* from);
-
-		void ExecuteOneParameterFunction(TokenType functionName);
-		void ExecuteTwoParameterFunction(TokenType functionName);
-		void ExecuteThreeParameterFunction(TokenType functionName);
-		void ExecuteFourParameterFunction(TokenType functionName);
-		void CreateVector();
-		void CreateMatrix(TokenType t);
-
-		const TokenType GetToken(const bool ignoreSign = false);
-		void Primary(const bool get);
-		void Power(const bool get);
-		void Term(const bool get);
-		void AddSubtract(const bool get);
-
-		inline void CheckToken(const TokenType wanted)
-		{
-			if (type_ != wanted)
-			{
-				std::ostringstream s;
-				s << "'" << static_cast <char>(wanted) << "' expected.";
-				Throw_error(__FILE__, __LINE__, __func__, s.str().c_str());
-			}
-		}
-	};
-
-}
-
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <iomanip>
+
+#include "constants.h"
+#include "operations.h"
+#include "functions.h"
+#include "types.h"
+#include "symbols.h"
+#include "context.h"
+#include "arena.h"
+#include "expression.h"
+#include "error.h"
+
+
+namespace Math_solver {
+
+	class Parser
+	{
+
+	private:
+		std::string program_;	// owned copy, if the parser was given a string
+		std::string_view source_;
+
+		const char* pWord_;
+		const char* pWordStart_;
+		const char* pEnd_;
+
+		TokenType type_;
+		std::string_view word_;	// current token, view into the source
+		value_t value_;
+
+		NodeArena arena_;
+		std::vector<BaseNode*> nodes;
+
+		Context& context_;
+		unsigned int variable_index_;
+
+		std::vector<std::string> parameters_;
+		unsigned int parameter_index_;
+
+		bool is_result_;
+		unsigned int depth_;	// nested AddSubtract calls, bounded so deep input can't overflow the stack
+
+		unsigned int num_tokens_;	// counted while parsing, added to metrics of the context at once
+		unsigned int num_names_resolved_;
+
+	public:
+		// variables are looked up and assigned in "context", which must outlive
+		// the parser and expressions compiled by it
+		Parser(const std::string& program, Context& context)
+			: program_(program), source_(program_), pWord_(nullptr), pWordStart_(nullptr), pEnd_(nullptr), type_(NONE),
+			context_(context), variable_index_(0), parameter_index_(0), is_result_(false), depth_(0),
+			num_tokens_(0), num_names_resolved_(0)
+		{
+		}
+
+		// parses "length" bytes at "source" in place, without copying them - the
+		// buffer may be shared by many parsers and must outlive them
+		Parser(const char* source, size_t length, Context& context)
+			: source_(source, length), pWord_(nullptr), pWordStart_(nullptr), pEnd_(nullptr), type_(NONE),
+			context_(context), variable_index_(0), parameter_index_(0), is_result_(false), depth_(0),
+			num_tokens_(0), num_names_resolved_(0)
+		{
+		}
+
+		// uses default context of the calling thread
+		Parser(const std::string& program)
+			: Parser(program, Get_default_context())
+		{
+		}
+
+		Parser(const Parser&) = delete;
+		Parser& operator=(const Parser&) = delete;
+
+		// parse once, evaluate many times; "parameters" are names bound at evaluation (by index),
+		// shapes declared in "parameter_shapes" are checked at compile time, others are guessed
+		CompiledExpression Compile(const std::vector<std::string>& parameters = std::vector<std::string>(),
+			const std::vector<shape_t>& parameter_shapes = std::vector<shape_t>());
+
+		const value_t Evaluate();
+		const value_t Evaluate(const std::string& program);
+		const value_t Evaluate(const char* source, size_t length); // in place, as the view constructor
+
+		bool IsResult() const { return is_result_; }
+
+		// only splits the source into tokens (as Compile would read them), returns their count
+		unsigned int Lex();
+
+	private:
+
+		CompiledExpression Build(const std::vector<std::string>& parameters, const std::vector<shape_t>& parameter_shapes, bool is_native);
+
+		void ExecuteOneParameterFunction(TokenType functionName);
+		void ExecuteTwoParameterFunction(TokenType functionName);
+		void ExecuteThreeParameterFunction(TokenType functionName);
+		void ExecuteFourParameterFunction(TokenType functionName);
+		void CreateVector(TokenType t, unsigned int num_dims);
+		void CreateMatrix(TokenType t, unsigned int num_dims);
+
+		const TokenType GetToken(const bool ignoreSign = false);
+		void UpdateMetrics(bool is_failed); // adds counts of the last parse (and created nodes) to the context
+		void Primary(const bool get);
+		void Power(const bool get);
+		void Term(const bool get);
+		void AddSubtract(const bool get);
+
+		inline bool IsAtEnd() const { return pWord_ == pEnd_; }
+
+		inline void SkipSpaces()
+		{
+			while (pWord_ != pEnd_ && isspace((unsigned char)*pWord_))
+				++pWord_;
+		}
+
+		inline void CheckToken(const TokenType wanted)
+		{
+			if (type_ != wanted)
+			{
+				std::ostringstream s;
+				s << "'" << static_cast <char>(wanted) << "' expected.";
+				Throw_error(__FILE__, __LINE__, __func__, s.str().c_str());
+			}
+		}
+	};
+
+}
+
 #endif // !PARSER_H
\ No newline at end of file
@@ -0,0 +1,648 @@
+#include "program.h"
+#include "operations.h"
+#include "config.h"
+#include "jit.h"
+#include "error.h"
+
+#include <type_traits>
+
+
+namespace Math_solver {
+
+	// registers are raw memory, results are constructed in place
+	static_assert(std::is_trivially_destructible<value_t>::value, "value_t must be trivially destructible");
+
+	static const unsigned int SMALL_PROGRAM_SIZE = 32;
+
+	static const char* Function_name(TokenType func)
+	{
+		for (const builtin_function_t& function : BUILTIN_FUNCTIONS)
+			if (function.token == func)
+				return function.name;
+
+		return (func == FACTORIAL) ? "!" : "?";
+	}
+
+	static bool Element_op(char oper, bool is_reversed, ElementOp& op)
+	{
+		switch (oper)
+		{
+		case '+': op = ELEMENT_ADD; return true;
+		case '-': op = is_reversed ? ELEMENT_SUBTRACT_REVERSED : ELEMENT_SUBTRACT; return true;
+		case '*': op = ELEMENT_MULTIPLY; return true;
+		case '/': op = is_reversed ? ELEMENT_DIVIDE_REVERSED : ELEMENT_DIVIDE; return true;
+		}
+
+		return false;
+	}
+
+	// operand shapes are known and accepted by Operator_shape
+	static Kernel Select_kernel(char oper, const shape_t& left, const shape_t& right, ElementOp& op)
+	{
+		if (left.is_scalar() && right.is_scalar())
+			return KERNEL_SCALAR;
+
+		if (!left.is_mat && !right.is_mat)
+		{
+			if (right.is_scalar() && Element_op(oper, false, op))
+				return KERNEL_VECTOR_SCALAR;
+
+			if (left.is_scalar() && Element_op(oper, true, op))
+				return KERNEL_SCALAR_VECTOR;
+
+			if (left.num_dims == right.num_dims && (oper == '+' || oper == '-') && Element_op(oper, false, op))
+				return KERNEL_VECTOR_VECTOR;
+		}
+
+		if (left.is_mat && right.is_scalar() && Element_op(oper, false, op))
+			return KERNEL_MATRIX_SCALAR;
+
+		if (left.is_scalar() && right.is_mat && Element_op(oper, true, op))
+			return KERNEL_SCALAR_MATRIX;
+
+		if (oper == '*' && left.is_mat && left.num_dims == 4 && right.num_dims == 4)
+			return right.is_mat ? KERNEL_MAT4_MAT4 : KERNEL_MAT4_VEC4;
+
+		return KERNEL_GENERIC;
+	}
+
+	// element-wise kernels take the vector or matrix operand first
+	static element_kernel_t Element_kernel(Kernel kernel, ElementOp op)
+	{
+		switch (kernel)
+		{
+		case KERNEL_VECTOR_VECTOR:
+			return Get_vector_vector_kernel(op);
+		case KERNEL_VECTOR_SCALAR:
+		case KERNEL_SCALAR_VECTOR:
+			return Get_vector_scalar_kernel(op);
+		case KERNEL_MATRIX_SCALAR:
+		case KERNEL_SCALAR_MATRIX:
+			return Get_matrix_scalar_kernel(op);
+		default:
+			return nullptr;
+		}
+	}
+
+	Program::Program()
+		: slots_(nullptr), num_token_counts_(0), num_registers_(0)
+	{
+	}
+
+	Program::~Program()
+	{
+	}
+
+	unsigned int Program::add(OpCode code, unsigned int index, char oper, TokenType func, unsigned int num_parameters, const unsigned int* operands)
+	{
+		Instruction instruction;
+
+		instruction.code = code;
+		instruction.oper = oper;
+		instruction.num_parameters = (unsigned char)num_parameters;
+		instruction.func = func;
+		instruction.index = index;
+
+		for (unsigned int i = 0; i < 4; i++)
+			instruction.operands[i] = (operands != nullptr && i < num_parameters) ? operands[i] : 0;
+
+		instruction.shape = shape_t::unknown();
+		instruction.kernel = KERNEL_GENERIC;
+		instruction.element_kernel = nullptr;
+		instruction.function = nullptr;
+
+		code_.push_back(instruction);
+
+		return (unsigned int)code_.size() - 1;
+	}
+
+	shape_t Program::get_parameter_shape(unsigned int index) const
+	{
+		if (index < parameter_shapes_.size() && parameter_shapes_[index].is_known())
+			return parameter_shapes_[index];
+
+		return shape_t::scalar(true);
+	}
+
+	unsigned int Program::add_constant(const value_t& value)
+	{
+		constants_.push_back(value);
+
+		unsigned int position = add(OP_CONSTANT, (unsigned int)constants_.size() - 1);
+		code_[position].shape = shape_t::of(value);
+
+		return position;
+	}
+
+	unsigned int Program::add_parameter(unsigned int index)
+	{
+		unsigned int position = add(OP_PARAMETER, index);
+		code_[position].shape = get_parameter_shape(index);
+
+		return position;
+	}
+
+	unsigned int Program::add_load(std::vector<value_t>* slots, unsigned int index)
+	{
+		slots_ = slots;
+
+		// variable may be reassigned to other shape before evaluation
+		unsigned int position = add(OP_LOAD, index);
+		code_[position].shape = shape_t::of((*slots)[index], true);
+
+		return position;
+	}
+
+	unsigned int Program::add_store(std::vector<value_t>* slots, unsigned int index, unsigned int operand)
+	{
+		slots_ = slots;
+
+		unsigned int position = add(OP_STORE, index, 0, NONE, 1, &operand);
+		code_[position].shape = code_[operand].shape;
+
+		return position;
+	}
+
+	unsigned int Program::add_operator(char oper, unsigned int left, unsigned int right)
+	{
+		unsigned int operands[2] = { left, right };
+		unsigned int position = add(OP_OPERATOR, num_registers_++, oper, NONE, 2, operands);
+
+		Instruction& instruction = code_[position];
+		shape_t left_shape = code_[left].shape;
+		shape_t right_shape = code_[right].shape;
+
+		if (!left_shape.is_known() || !right_shape.is_known())
+			return position;
+
+		bool is_guess = left_shape.is_guess || right_shape.is_guess;
+		shape_t shape;
+
+		if (!Operator_shape(oper, left_shape, right_shape, shape))
+		{
+			if (!is_guess) // would fail on every evaluation
+				Throw_error(__FILE__, __LINE__, __func__, "Wrong operand shapes for operator: %c", oper);
+
+			return position;
+		}
+
+		ElementOp element_op = ELEMENT_ADD;
+
+		instruction.shape = shape;
+		instruction.shape.is_guess = is_guess;
+		instruction.kernel = Select_kernel(oper, left_shape, right_shape, element_op);
+		instruction.element_kernel = Element_kernel(instruction.kernel, element_op);
+
+		return position;
+	}
+
+	unsigned int Program::add_function(TokenType func, const unsigned int* parameters, unsigned int num_parameters)
+	{
+		if (num_parameters == 0 || num_parameters > 4)
+			Throw_error(__FILE__, __LINE__, __func__, "Wrong number of parameters: %u", num_parameters);
+
+		unsigned int position = add(OP_FUNCTION, num_registers_++, 0, func, num_parameters, parameters);
+
+		Instruction& instruction = code_[position];
+		shape_t shapes[4];
+		bool is_guess = false;
+
+		for (unsigned int i = 0; i < num_parameters; i++)
+		{
+			shapes[i] = code_[parameters[i]].shape;
+
+			if (!shapes[i].is_known())
+				return position;
+
+			is_guess = is_guess || shapes[i].is_guess;
+		}
+
+		if (!Function_shape(func, shapes, num_parameters, instruction.shape))
+		{
+			if (!is_guess)
+				Throw_error(__FILE__, __LINE__, __func__, "Wrong parameter shapes for function: %s", Function_name(func));
+
+			instruction.shape = shape_t::unknown();
+			return position;
+		}
+
+		instruction.shape.is_guess = is_guess;
+
+		if (num_parameters == 1 && code_[parameters[0]].shape.is_scalar() && (instruction.function = Scalar_function(func)) != nullptr)
+			instruction.kernel = KERNEL_SCALAR_FUNCTION;
+
+		return position;
+	}
+
+	// token of the node the instruction was lowered from
+	static TokenType Instruction_token(const Instruction& instruction)
+	{
+		switch (instruction.code)
+		{
+		case OP_CONSTANT:
+			return SCALAR;
+		case OP_PARAMETER:
+			return VARIABLE_PARAMETER;
+		case OP_LOAD:
+			return VARIABLE_REFERENCE;
+		case OP_STORE:
+			return VARIABLE_ASSIGN;
+		case OP_OPERATOR:
+			return TokenType(instruction.oper);
+		default:
+			return instruction.func;
+		}
+	}
+
+	void Program::finish(bool is_native)
+	{
+		// programs have a few distinct tokens, searched linearly
+		num_token_counts_ = 0;
+
+		for (const Instruction& instruction : code_)
+		{
+			TokenType token = Instruction_token(instruction);
+			unsigned int i = 0;
+
+			while (i < num_token_counts_ && token_counts_[i].token != token)
+				i++;
+
+			if (i == num_token_counts_)
+			{
+				if (i == MAX_NODE_TOKENS)
+					continue;
+
+				token_counts_[num_token_counts_++] = { token, 0 };
+			}
+
+			token_counts_[i].count++;
+		}
+
+		scalar_code_.clear();
+
+		for (const Instruction& instruction : code_)
+		{
+			ScalarInstruction scalar;
+
+			if (!instruction.shape.is_scalar())
+				break;
+
+			scalar.oper = instruction.oper;
+			scalar.index = instruction.index;
+			scalar.operands[0] = instruction.operands[0];
+			scalar.operands[1] = instruction.operands[1];
+			scalar.function = instruction.function;
+			scalar.constant = 0.0;
+
+			switch (instruction.code)
+			{
+			case OP_CONSTANT:
+				scalar.code = SCALAR_CONSTANT;
+				scalar.constant = constants_[instruction.index].vec.to_scalar();
+				break;
+
+			case OP_PARAMETER:
+				scalar.code = SCALAR_PARAMETER;
+				break;
+
+			case OP_LOAD:
+				scalar.code = SCALAR_LOAD;
+				break;
+
+			case OP_STORE:
+				scalar.code = SCALAR_STORE;
+				break;
+
+			case OP_OPERATOR:
+				switch (instruction.oper)
+				{
+				case '+': scalar.code = SCALAR_ADD; break;
+				case '-': scalar.code = SCALAR_SUBTRACT; break;
+				case '*': scalar.code = SCALAR_MULTIPLY; break;
+				case '/': scalar.code = SCALAR_DIVIDE; break;
+				default: scalar.code = SCALAR_OPERATOR; break;
+				}
+				break;
+
+			case OP_FUNCTION:
+				if (instruction.kernel != KERNEL_SCALAR_FUNCTION)
+				{
+					scalar_code_.clear();
+					return;
+				}
+
+				scalar.code = SCALAR_FUNCTION;
+				break;
+			}
+
+			scalar_code_.push_back(scalar);
+		}
+
+		if (scalar_code_.size() != code_.size())
+		{
+			scalar_code_.clear();
+			return;
+		}
+
+		if (!USE_JIT || !is_native)
+			return;
+
+		jit_ = Jit_compile(scalar_code_);
+		jit_inputs_.clear();
+		jit_stores_.clear();
+
+		for (unsigned int i = 0; i < scalar_code_.size(); i++)
+		{
+			if (scalar_code_[i].code == SCALAR_PARAMETER || scalar_code_[i].code == SCALAR_LOAD)
+				jit_inputs_.push_back(i);
+			else if (scalar_code_[i].code == SCALAR_STORE)
+				jit_stores_.push_back(i);
+		}
+	}
+
+	// scalar of a binding, false if it isn't one
+	static inline bool To_scalar(const value_t& value, double& scalar)
+	{
+		if (!value.is_scalar())
+			return false;
+
+		scalar = value.vec.to_scalar();
+		return true;
+	}
+
+	static inline bool To_scalar(double value, double& scalar)
+	{
+		scalar = value;
+		return true;
+	}
+
+	template<typename Binding>
+	bool Program::run_jit(const Binding* bindings, size_t num_bindings, double& result) const
+	{
+		double small_values[SMALL_PROGRAM_SIZE];
+		std::vector<double> large_values;
+
+		double* values = small_values;
+
+		if (scalar_code_.size() > SMALL_PROGRAM_SIZE) {
+			large_values.resize(scalar_code_.size());
+			values = large_values.data();
+		}
+
+		for (unsigned int position : jit_inputs_)
+		{
+			const ScalarInstruction& instruction = scalar_code_[position];
+
+			if (instruction.code == SCALAR_PARAMETER)
+			{
+				if (instruction.index >= num_bindings)
+					Throw_error(__FILE__, __LINE__, __func__, "Unbound parameter: %u", instruction.index);
+
+				if (!To_scalar(bindings[instruction.index], values[position]))
+					return false;
+			}
+			else if (!To_scalar((*slots_)[instruction.index], values[position]))
+				return false;
+		}
+
+		if (jit_->run(values) == JIT_DIVISION_BY_ZERO)
+			Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+		for (unsigned int position : jit_stores_)
+			(*slots_)[scalar_code_[position].index] = value_t(values[position]);
+
+		result = values[scalar_code_.size() - 1];
+		return true;
+	}
+
+	template<typename Binding>
+	bool Program::run_scalar(const Binding* bindings, size_t num_bindings, double& result) const
+	{
+		// one value per instruction
+		double small_values[SMALL_PROGRAM_SIZE];
+		std::vector<double> large_values;
+
+		double* values = small_values;
+
+		if (scalar_code_.size() > SMALL_PROGRAM_SIZE) {
+			large_values.resize(scalar_code_.size());
+			values = large_values.data();
+		}
+
+		for (size_t i = 0; i < scalar_code_.size(); i++)
+		{
+			const ScalarInstruction& instruction = scalar_code_[i];
+
+			switch (instruction.code)
+			{
+			case SCALAR_CONSTANT:
+				values[i] = instruction.constant;
+				break;
+
+			case SCALAR_PARAMETER:
+			{
+				if (instruction.index >= num_bindings)
+					Throw_error(__FILE__, __LINE__, __func__, "Unbound parameter: %u", instruction.index);
+
+				if (!To_scalar(bindings[instruction.index], values[i]))
+					return false;
+
+				break;
+			}
+
+			case SCALAR_LOAD:
+				if (!To_scalar((*slots_)[instruction.index], values[i]))
+					return false;
+
+				break;
+
+			case SCALAR_STORE:
+				values[i] = values[instruction.operands[0]];
+				(*slots_)[instruction.index] = value_t(values[i]);
+				break;
+
+			case SCALAR_ADD:
+				values[i] = values[instruction.operands[0]] + values[instruction.operands[1]];
+				break;
+
+			case SCALAR_SUBTRACT:
+				values[i] = values[instruction.operands[0]] - values[instruction.operands[1]];
+				break;
+
+			case SCALAR_MULTIPLY:
+				values[i] = values[instruction.operands[0]] * values[instruction.operands[1]];
+				break;
+
+			case SCALAR_DIVIDE:
+				if (values[instruction.operands[1]] == 0.0)
+					Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+				values[i] = values[instruction.operands[0]] / values[instruction.operands[1]];
+				break;
+
+			case SCALAR_OPERATOR:
+				values[i] = Scalar_oper(instruction.oper, values[instruction.operands[0]], values[instruction.operands[1]]);
+				break;
+
+			case SCALAR_FUNCTION:
+				values[i] = instruction.function(values[instruction.operands[0]]);
+				break;
+			}
+		}
+
+		result = values[scalar_code_.size() - 1];
+		return true;
+	}
+
+	bool Program::run(const double* bindings, size_t num_bindings, double& result) const
+	{
+		if (jit_)
+			return run_jit(bindings, num_bindings, result);
+
+		return !scalar_code_.empty() && run_scalar(bindings, num_bindings, result);
+	}
+
+	value_t Program::run(const value_t* bindings, size_t num_bindings, RandomStream* rng) const
+	{
+		double scalar;
+
+		if (jit_ && run_jit(bindings, num_bindings, scalar))
+			return value_t(scalar);
+
+		return run_interpreter(bindings, num_bindings, rng);
+	}
+
+	value_t Program::run_interpreter(const value_t* bindings, size_t num_bindings, RandomStream* rng) const
+	{
+		static const value_t zero;
+
+		if (code_.empty())
+			return value_t();
+
+		double scalar;
+
+		if (!scalar_code_.empty() && run_scalar(bindings, num_bindings, scalar))
+			return value_t(scalar);
+
+		// small programs use stack memory only
+		const value_t* small_values[SMALL_PROGRAM_SIZE];
+		alignas(value_t) unsigned char small_registers[SMALL_PROGRAM_SIZE * sizeof(value_t)];
+
+		std::vector<const value_t*> large_values;
+		std::vector<value_t> large_registers;
+
+		const value_t** values = small_values; // value of each instruction
+		value_t* registers = reinterpret_cast<value_t*>(small_registers);
+
+		if (code_.size() > SMALL_PROGRAM_SIZE) {
+			large_values.resize(code_.size());
+			large_registers.resize(num_registers_);
+
+			values = large_values.data();
+			registers = large_registers.data();
+		}
+
+		// kernels rely on guessed shapes until one of them is wrong
+		bool is_specialized = true;
+
+		for (size_t i = 0; i < code_.size(); i++)
+		{
+			const Instruction& instruction = code_[i];
+
+			switch (instruction.code)
+			{
+			case OP_CONSTANT:
+				values[i] = &constants_[instruction.index];
+				break;
+
+			case OP_PARAMETER:
+				if (instruction.index >= num_bindings)
+					Throw_error(__FILE__, __LINE__, __func__, "Unbound parameter: %u", instruction.index);
+
+				values[i] = &bindings[instruction.index];
+
+				if (!instruction.shape.matches(*values[i]))
+				{
+					if (!instruction.shape.is_guess)
+						Throw_error(__FILE__, __LINE__, __func__, "Parameter %u has wrong shape", instruction.index);
+
+					is_specialized = false;
+				}
+				break;
+
+			case OP_LOAD:
+				values[i] = &(*slots_)[instruction.index];
+
+				if (!instruction.shape.matches(*values[i]))
+					is_specialized = false;
+				break;
+
+			case OP_STORE:
+				(*slots_)[instruction.index] = *values[instruction.operands[0]];
+				values[i] = &(*slots_)[instruction.index];
+				break;
+
+			case OP_OPERATOR:
+			{
+				const value_t& left = *values[instruction.operands[0]];
+				const value_t& right = *values[instruction.operands[1]];
+				value_t* result = &registers[instruction.index];
+
+				switch (is_specialized ? instruction.kernel : KERNEL_GENERIC)
+				{
+				case KERNEL_SCALAR:
+					new(result) value_t(Scalar_oper(instruction.oper, left.vec.to_scalar(), right.vec.to_scalar()));
+					break;
+				case KERNEL_VECTOR_VECTOR:
+				case KERNEL_VECTOR_SCALAR:
+				case KERNEL_MATRIX_SCALAR:
+					new(result) value_t(instruction.element_kernel(left, right));
+					break;
+				case KERNEL_SCALAR_VECTOR:
+				case KERNEL_SCALAR_MATRIX:
+					new(result) value_t(instruction.element_kernel(right, left));
+					break;
+				case KERNEL_MAT4_MAT4:
+					new(result) value_t(left.mat.to_mat4() * right.mat.to_mat4(), 4);
+					break;
+				case KERNEL_MAT4_VEC4:
+					new(result) value_t(left.mat.to_mat4() * right.vec.to_vec4(), 4);
+					break;
+				default:
+					if (left.is_scalar() && right.is_scalar())
+						new(result) value_t(Scalar_oper(instruction.oper, left.vec.to_scalar(), right.vec.to_scalar()));
+					else
+						new(result) value_t(Do_oper(instruction.oper, left, right));
+				}
+
+				values[i] = result;
+				break;
+			}
+
+			case OP_FUNCTION:
+			{
+				unsigned int n = instruction.num_parameters;
+
+				if (is_specialized && instruction.kernel == KERNEL_SCALAR_FUNCTION)
+					new(&registers[instruction.index]) value_t(instruction.function(values[instruction.operands[0]]->vec.to_scalar()));
+				else
+					new(&registers[instruction.index]) value_t(Do_func(instruction.func,
+						*values[instruction.operands[0]],
+						(n > 1) ? *values[instruction.operands[1]] : zero,
+						(n > 2) ? *values[instruction.operands[2]] : zero,
+						(n > 3) ? *values[instruction.operands[3]] : zero,
+						rng));
+
+				values[i] = &registers[instruction.index];
+				break;
+			}
+
+			default:
+				Throw_error(__FILE__, __LINE__, __func__, "Unknown instruction: %d", instruction.code);
+			}
+		}
+
+		return *values[code_.size() - 1];
+	}
+
+}
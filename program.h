@@ -0,0 +1,169 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <memory>
+#include <vector>
+
+#include "functions.h"
+#include "types.h"
+#include "random.h"
+#include "operations.h"
+#include "metrics.h"
+
+
+namespace Math_solver {
+
+	enum OpCode : unsigned char
+	{
+		OP_CONSTANT,	// constants[index]
+		OP_PARAMETER,	// bindings[index]
+		OP_LOAD,		// slots[index]
+		OP_STORE,		// slots[index] = operands[0]
+		OP_OPERATOR,	// operands[0] oper operands[1]
+		OP_FUNCTION		// func(operands[0..num_parameters))
+	};
+
+	// operation selected from operand shapes known at compile time
+	enum Kernel : unsigned char
+	{
+		KERNEL_GENERIC,			// Do_oper / Do_func dispatch on shapes at runtime
+		KERNEL_SCALAR,			// Scalar_oper
+		KERNEL_VECTOR_VECTOR,	// element_kernel_t
+		KERNEL_VECTOR_SCALAR,	// element_kernel_t, vector on the left
+		KERNEL_SCALAR_VECTOR,	// element_kernel_t, vector on the right
+		KERNEL_MATRIX_SCALAR,	// element_kernel_t, matrix on the left
+		KERNEL_SCALAR_MATRIX,	// element_kernel_t, matrix on the right
+		KERNEL_MAT4_MAT4,
+		KERNEL_MAT4_VEC4,
+		KERNEL_SCALAR_FUNCTION	// scalar_function_t
+	};
+
+	struct Instruction
+	{
+		OpCode code;
+		char oper;
+		unsigned char num_parameters;
+		TokenType func;
+		unsigned int index;			// constant / parameter / slot / register
+		unsigned int operands[4];	// positions of instructions producing the operands
+
+		shape_t shape;				// of the result
+		Kernel kernel;
+		element_kernel_t element_kernel;
+		scalar_function_t function;
+	};
+
+	// instruction of the double-only form of a program with scalar shapes only
+	enum ScalarOpCode : unsigned char
+	{
+		SCALAR_CONSTANT,
+		SCALAR_PARAMETER,
+		SCALAR_LOAD,
+		SCALAR_STORE,
+		SCALAR_ADD,
+		SCALAR_SUBTRACT,
+		SCALAR_MULTIPLY,
+		SCALAR_DIVIDE,
+		SCALAR_OPERATOR,	// Scalar_oper
+		SCALAR_FUNCTION
+	};
+
+	struct ScalarInstruction
+	{
+		ScalarOpCode code;
+		char oper;
+		unsigned int index;
+		unsigned int operands[2];
+		scalar_function_t function;
+		double constant;
+	};
+
+	class JitCode;
+
+	// Expression tree lowered to a linear post-order instruction stream. Every
+	// instruction refers to its operands by position, results of operators and
+	// functions are computed directly into their own register, so values are
+	// never copied between instructions.
+	//
+	// Shapes are inferred while instructions are added: combinations of known
+	// shapes which can't be evaluated are rejected right away, valid ones get
+	// a specialized kernel. Programs made of scalars only are also translated
+	// to a pure double instruction stream.
+	class Program
+	{
+	private:
+		std::vector<Instruction> code_;
+		std::vector<value_t> constants_;
+		std::vector<value_t>* slots_;
+		std::vector<shape_t> parameter_shapes_;
+
+		std::vector<ScalarInstruction> scalar_code_; // empty unless all shapes are scalar
+
+		std::unique_ptr<JitCode> jit_; // native code of "scalar_code_", if it could be compiled
+		std::vector<unsigned int> jit_inputs_; // positions of parameters and loads
+		std::vector<unsigned int> jit_stores_;
+
+		token_count_t token_counts_[MAX_NODE_TOKENS]; // nodes of the program by token, for metrics
+		unsigned int num_token_counts_;
+
+		unsigned int num_registers_;
+
+		unsigned int add(OpCode code, unsigned int index, char oper = 0, TokenType func = NONE, unsigned int num_parameters = 0, const unsigned int* operands = nullptr);
+
+		// false if a guessed shape turned out wrong; bindings are values or plain doubles
+		template<typename Binding>
+		bool run_scalar(const Binding* bindings, size_t num_bindings, double& result) const;
+		template<typename Binding>
+		bool run_jit(const Binding* bindings, size_t num_bindings, double& result) const;
+
+	public:
+		Program();
+		~Program();
+
+		Program(const Program&) = delete;
+		Program& operator=(const Program&) = delete;
+
+		// declared shapes of parameters, must be set before they are added;
+		// parameters without one are guessed to be scalars
+		void set_parameter_shapes(const std::vector<shape_t>& shapes) { parameter_shapes_ = shapes; }
+		shape_t get_parameter_shape(unsigned int index) const;
+
+		// each returns position of the added instruction
+		unsigned int add_constant(const value_t& value);
+		unsigned int add_parameter(unsigned int index);
+		unsigned int add_load(std::vector<value_t>* slots, unsigned int index);
+		unsigned int add_store(std::vector<value_t>* slots, unsigned int index, unsigned int operand);
+		unsigned int add_operator(char oper, unsigned int left, unsigned int right);
+		unsigned int add_function(TokenType func, const unsigned int* parameters, unsigned int num_parameters);
+
+		// called once all instructions are added; native code pays off only
+		// for programs run many times, one-shot evaluation goes without it
+		void finish(bool is_native = true);
+
+		// native code when available, interpreter otherwise
+		value_t run(const value_t* bindings, size_t num_bindings, RandomStream* rng) const;
+
+		// scalar programs only: bindings and registers are plain doubles, no value_t
+		// is built; false if the program isn't scalar or a variable it loads isn't
+		bool run(const double* bindings, size_t num_bindings, double& result) const;
+
+		// reference semantics, never uses native code
+		value_t run_interpreter(const value_t* bindings, size_t num_bindings, RandomStream* rng) const;
+
+		value_t run(const Bindings& bindings, RandomStream* rng) const
+		{
+			return run(bindings.data(), bindings.size(), rng);
+		}
+
+		const std::vector<Instruction>& get_code() const { return code_; }
+		const std::vector<value_t>& get_constants() const { return constants_; }
+		unsigned int get_num_registers() const { return num_registers_; }
+		bool is_scalar() const { return !scalar_code_.empty(); }
+		bool is_native() const { return jit_ != nullptr; }
+		const token_count_t* get_token_counts() const { return token_counts_; }
+		unsigned int get_num_token_counts() const { return num_token_counts_; }
+	};
+
+}
+
+#endif // !PROGRAM_H
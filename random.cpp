@@ -0,0 +1,69 @@
+#include "random.h"
+
+
+namespace Math_solver {
+
+	static const uint32_t PHILOX_M0 = 0xD2511F53;
+	static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+	static const uint32_t PHILOX_W0 = 0x9E3779B9; // golden ratio
+	static const uint32_t PHILOX_W1 = 0xBB67AE85; // sqrt(3) - 1
+
+	void Philox_4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t output[4])
+	{
+		uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+		uint32_t k0 = key[0], k1 = key[1];
+
+		for (unsigned int round = 0; round < 10; round++)
+		{
+			uint64_t product0 = (uint64_t)PHILOX_M0 * c0;
+			uint64_t product1 = (uint64_t)PHILOX_M1 * c2;
+
+			c0 = (uint32_t)(product1 >> 32) ^ c1 ^ k0;
+			c2 = (uint32_t)(product0 >> 32) ^ c3 ^ k1;
+			c1 = (uint32_t)product1;
+			c3 = (uint32_t)product0;
+
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+
+		output[0] = c0;
+		output[1] = c1;
+		output[2] = c2;
+		output[3] = c3;
+	}
+
+	uint32_t RandomStream::next()
+	{
+		if (used_ == 4)
+		{
+			Philox_4x32(counter_, key_, block_);
+
+			counter_[0]++;
+			used_ = 0;
+		}
+
+		return block_[used_++];
+	}
+
+	uint32_t RandomStream::next_below(uint32_t range)
+	{
+		// multiply-shift, rejecting the few low products which would bias it
+		uint64_t product = (uint64_t)next() * range;
+		uint32_t low = (uint32_t)product;
+
+		if (low < range)
+		{
+			uint32_t threshold = (uint32_t)(0 - range) % range;
+
+			while (low < threshold)
+			{
+				product = (uint64_t)next() * range;
+				low = (uint32_t)product;
+			}
+		}
+
+		return (uint32_t)(product >> 32);
+	}
+
+}
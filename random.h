@@ -0,0 +1,54 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+
+namespace Math_solver {
+
+	// Counter-based generator (Philox4x32-10). Output is a pure function of
+	// (seed, stream, row, draw), nothing is shared between streams, so rows
+	// can be evaluated in any order on any number of threads and still get
+	// the same numbers. A row starts at draw 0, every draw moves to the next
+	// 32-bit word, four words are produced per block.
+	class RandomStream
+	{
+	private:
+		uint32_t key_[2];
+		uint32_t counter_[4];	// { block, row low, row high, stream }
+		uint32_t block_[4];
+		unsigned int used_;		// words of "block_" already returned
+
+	public:
+		RandomStream(uint64_t seed = 0, uint32_t stream = 0)
+			: used_(4)
+		{
+			key_[0] = (uint32_t)seed;
+			key_[1] = (uint32_t)(seed >> 32);
+
+			counter_[0] = 0;
+			counter_[1] = 0;
+			counter_[2] = 0;
+			counter_[3] = stream;
+		}
+
+		void set_row(uint64_t row)
+		{
+			counter_[0] = 0;
+			counter_[1] = (uint32_t)row;
+			counter_[2] = (uint32_t)(row >> 32);
+			used_ = 4;
+		}
+
+		uint32_t next();
+
+		// uniform integer in [0, range), without modulo bias
+		uint32_t next_below(uint32_t range);
+	};
+
+	// single Philox4x32-10 block
+	void Philox_4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t output[4]);
+
+}
+
+#endif // !RANDOM_H
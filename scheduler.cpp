@@ -0,0 +1,184 @@
+#include "scheduler.h"
+
+
+namespace Math_solver {
+
+	Scheduler::Scheduler(unsigned int num_threads)
+		: generation_(0), num_busy_(0), stop_(false), task_(nullptr), failed_(false)
+	{
+		if (num_threads == 0)
+			num_threads = std::thread::hardware_concurrency();
+
+		if (num_threads == 0)
+			num_threads = 1;
+
+		for (unsigned int i = 0; i < num_threads; i++)
+		{
+			queues_.emplace_back(new queue_t());
+			queues_.back()->begin = 0;
+			queues_.back()->end = 0;
+		}
+
+		for (unsigned int i = 1; i < num_threads; i++)
+			threads_.emplace_back(&Scheduler::loop, this, i);
+	}
+
+	Scheduler::~Scheduler()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			stop_ = true;
+		}
+
+		start_.notify_all();
+
+		for (std::thread& thread : threads_)
+			thread.join();
+	}
+
+	bool Scheduler::pop(unsigned int worker, size_t& task)
+	{
+		queue_t& queue = *queues_[worker];
+		std::lock_guard<std::mutex> guard(queue.lock);
+
+		if (queue.begin == queue.end)
+			return false;
+
+		task = queue.begin++;
+		return true;
+	}
+
+	bool Scheduler::steal(unsigned int worker)
+	{
+		unsigned int num_queues = (unsigned int)queues_.size();
+
+		for (unsigned int i = 1; i < num_queues; i++)
+		{
+			queue_t& victim = *queues_[(worker + i) % num_queues];
+			size_t begin, end;
+
+			{
+				std::lock_guard<std::mutex> guard(victim.lock);
+
+				if (victim.begin == victim.end)
+					continue;
+
+				// upper half, or the last task
+				begin = victim.begin + (victim.end - victim.begin) / 2;
+				end = victim.end;
+				victim.end = begin;
+			}
+
+			queue_t& queue = *queues_[worker];
+			std::lock_guard<std::mutex> guard(queue.lock);
+
+			queue.begin = begin;
+			queue.end = end;
+			return true;
+		}
+
+		return false;
+	}
+
+	void Scheduler::work(unsigned int worker)
+	{
+		size_t task;
+
+		while (!failed_.load(std::memory_order_relaxed))
+		{
+			if (!pop(worker, task))
+			{
+				if (!steal(worker))
+					break;
+
+				continue;
+			}
+
+			try
+			{
+				(*task_)(task);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+
+				if (!error_)
+					error_ = std::current_exception();
+
+				failed_ = true;
+			}
+		}
+	}
+
+	void Scheduler::loop(unsigned int worker)
+	{
+		unsigned long generation = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> guard(lock_);
+				start_.wait(guard, [&] { return stop_ || generation_ != generation; });
+
+				if (stop_)
+					return;
+
+				generation = generation_;
+			}
+
+			work(worker);
+
+			std::lock_guard<std::mutex> guard(lock_);
+
+			if (--num_busy_ == 0)
+				done_.notify_one();
+		}
+	}
+
+	void Scheduler::run(size_t num_tasks, const std::function<void(size_t)>& task)
+	{
+		if (num_tasks == 0)
+			return;
+
+		std::lock_guard<std::mutex> run_guard(run_lock_);
+
+		size_t num_queues = queues_.size();
+
+		for (size_t i = 0; i < num_queues; i++)
+		{
+			std::lock_guard<std::mutex> guard(queues_[i]->lock);
+
+			queues_[i]->begin = num_tasks * i / num_queues;
+			queues_[i]->end = num_tasks * (i + 1) / num_queues;
+		}
+
+		task_ = &task;
+		error_ = nullptr;
+		failed_ = false;
+
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			num_busy_ = (unsigned int)threads_.size();
+			generation_++;
+		}
+
+		start_.notify_all();
+
+		work(0);
+
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+			done_.wait(guard, [&] { return num_busy_ == 0; });
+		}
+
+		task_ = nullptr;
+
+		// leftovers after a failure
+		for (size_t i = 0; i < num_queues; i++)
+			queues_[i]->begin = queues_[i]->end = 0;
+
+		if (error_)
+			std::rethrow_exception(error_);
+	}
+
+}
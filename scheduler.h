@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace Math_solver {
+
+	// Fixed pool of worker threads running numbered tasks. Every worker starts
+	// with an equal contiguous range of tasks and takes them from its front;
+	// a worker which runs out steals the upper half of another worker's range,
+	// so tasks of uneven cost are balanced without a shared queue.
+	class Scheduler
+	{
+	private:
+		struct queue_t
+		{
+			std::mutex lock;
+			size_t begin;
+			size_t end;
+		};
+
+		std::vector<std::unique_ptr<queue_t>> queues_; // queues_[0] belongs to the calling thread
+		std::vector<std::thread> threads_;
+
+		std::mutex lock_;
+		std::condition_variable start_;
+		std::condition_variable done_;
+		unsigned long generation_;
+		unsigned int num_busy_;
+		bool stop_;
+
+		std::mutex run_lock_;
+		const std::function<void(size_t)>* task_;
+		std::exception_ptr error_;
+		std::atomic<bool> failed_;
+
+		bool pop(unsigned int worker, size_t& task);
+		bool steal(unsigned int worker);
+		void work(unsigned int worker);
+		void loop(unsigned int worker);
+
+	public:
+		// 0 threads means one per hardware thread, the calling thread counts as one
+		explicit Scheduler(unsigned int num_threads = 0);
+		~Scheduler();
+
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator=(const Scheduler&) = delete;
+
+		// runs task(i) for every i in [0, num_tasks), returns when all are done;
+		// first exception thrown by a task stops the rest and is rethrown here
+		void run(size_t num_tasks, const std::function<void(size_t)>& task);
+
+		unsigned int get_num_threads() const { return (unsigned int)queues_.size(); }
+	};
+
+}
+
+#endif // !SCHEDULER_H
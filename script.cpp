@@ -0,0 +1,283 @@
+#include "script.h"
+#include "parser.h"
+#include "output.h"
+#include "config.h"
+#include "error.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace Math_solver {
+
+#if defined(_WIN32)
+
+	MappedFile::MappedFile(const char* path)
+		: data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+	{
+		file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file_ == INVALID_HANDLE_VALUE)
+			Throw_error(__FILE__, __LINE__, __func__, "Can't open file: %s", path);
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file_, &size);
+		size_ = (size_t)size.QuadPart;
+
+		if (size_ == 0) // empty files can't be mapped
+			return;
+
+		mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping_ != nullptr)
+			data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+
+		if (data_ == nullptr)
+		{
+			if (mapping_ != nullptr)
+				CloseHandle(mapping_);
+
+			CloseHandle(file_);
+			Throw_error(__FILE__, __LINE__, __func__, "Can't map file: %s", path);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data_ != nullptr)
+			UnmapViewOfFile(data_);
+
+		if (mapping_ != nullptr)
+			CloseHandle(mapping_);
+
+		CloseHandle(file_);
+	}
+
+#else
+
+	MappedFile::MappedFile(const char* path)
+		: data_(nullptr), size_(0)
+	{
+		int file = open(path, O_RDONLY);
+
+		if (file < 0)
+			Throw_error(__FILE__, __LINE__, __func__, "Can't open file: %s", path);
+
+		struct stat status;
+
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			Throw_error(__FILE__, __LINE__, __func__, "Can't read file: %s", path);
+		}
+
+		size_ = (size_t)status.st_size;
+
+		if (size_ == 0) // empty files can't be mapped
+		{
+			close(file);
+			return;
+		}
+
+		void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file); // mapping keeps the file open
+
+		if (data == MAP_FAILED)
+			Throw_error(__FILE__, __LINE__, __func__, "Can't map file: %s", path);
+
+		madvise(data, size_, MADV_SEQUENTIAL);
+		data_ = (const char*)data;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data_ != nullptr)
+			munmap((void*)data_, size_);
+	}
+
+#endif
+
+	const size_t OUTPUT_BLOCK_SIZE = 64 * 1024;
+	const size_t INPUT_BLOCK_SIZE = 1024 * 1024;
+
+	// Runs statements line by line with one parser, whose buffers are reused;
+	// results are collected and written out in blocks.
+	class LineRunner
+	{
+	private:
+		Parser parser_;
+		Metrics& metrics_;
+		FILE* output_;
+		OutputFormat format_;
+		std::string buffer_;
+		size_t line_number_;
+
+		void write_result(const value_t& value)
+		{
+			PhaseTimer timer(metrics_);
+			metrics_.add_formatted();
+
+			if (format_ == OUTPUT_BINARY)
+			{
+				unsigned char record[RESULT_RECORD_SIZE];
+				buffer_.append((const char*)record, Write_result_record(value, record));
+			}
+			else
+			{
+				char text[VALUE_STR_SIZE];
+				buffer_.append(text, value.is_mat() ? value.mat.to_chars(text, PRECISION) : value.vec.to_chars(text, PRECISION));
+				buffer_ += '\n';
+			}
+
+			timer.lap(PHASE_FORMAT);
+		}
+
+		void write_error(const char* message)
+		{
+			std::string error = "Line " + std::to_string(line_number_) + ": " + message;
+
+			if (format_ == OUTPUT_BINARY)
+			{
+				unsigned char header[1 + sizeof(uint32_t)];
+				header[0] = RESULT_ERROR;
+				Write_little_endian((uint32_t)error.size(), header + 1);
+
+				buffer_.append((const char*)header, sizeof(header));
+				buffer_ += error;
+				return;
+			}
+
+			buffer_ += error;
+			buffer_ += '\n';
+		}
+
+	public:
+		LineRunner(Context& context, FILE* output, OutputFormat format)
+			: parser_(nullptr, 0, context), metrics_(context.get_metrics()), output_(output), format_(format), line_number_(0)
+		{
+			buffer_.reserve(OUTPUT_BLOCK_SIZE + 1024);
+		}
+
+		~LineRunner()
+		{
+			flush();
+		}
+
+		// statement is lexed where it lies, returns false if it failed
+		bool run(const char* line, size_t length)
+		{
+			line_number_++;
+
+			bool is_empty = true;
+
+			for (size_t i = 0; i < length && is_empty; i++)
+				is_empty = isspace((unsigned char)line[i]) != 0;
+
+			if (is_empty)
+				return true;
+
+			bool is_ok = true;
+
+			try
+			{
+				value_t value = parser_.Evaluate(line, length);
+
+				if (parser_.IsResult())
+					write_result(value);
+			}
+			catch (std::exception& e)
+			{
+				write_error(e.what());
+				is_ok = false;
+			}
+
+			if (buffer_.size() >= OUTPUT_BLOCK_SIZE)
+				flush();
+
+			return is_ok;
+		}
+
+		void flush()
+		{
+			fwrite(buffer_.data(), 1, buffer_.size(), output_);
+			buffer_.clear();
+		}
+	};
+
+	bool Run_script(const char* source, size_t length, Context& context, FILE* output, OutputFormat format)
+	{
+		const char* end = source + length;
+		LineRunner runner(context, output, format);
+
+		for (const char* line = source; line < end; )
+		{
+			const char* line_end = (const char*)memchr(line, '\n', end - line);
+
+			if (line_end == nullptr)
+				line_end = end;
+
+			if (!runner.run(line, line_end - line))
+				return false;
+
+			line = line_end + 1;
+		}
+
+		return true;
+	}
+
+	bool Run_pipe(FILE* input, FILE* output, Context& context, OutputFormat format)
+	{
+		std::vector<char> block(INPUT_BLOCK_SIZE);
+		size_t size = 0; // unfinished line from the previous block is kept at the start
+		bool is_ok = true;
+
+		LineRunner runner(context, output, format);
+
+		while (true)
+		{
+			if (size == block.size()) // line longer than the block
+				block.resize(block.size() * 2);
+
+			size_t num_read = fread(block.data() + size, 1, block.size() - size, input);
+			bool is_end = (num_read == 0);
+
+			size += num_read;
+
+			const char* line = block.data();
+			const char* end = block.data() + size;
+
+			while (line < end)
+			{
+				const char* line_end = (const char*)memchr(line, '\n', end - line);
+
+				if (line_end == nullptr)
+				{
+					if (!is_end)
+						break;
+
+					line_end = end; // last line without newline
+				}
+
+				is_ok &= runner.run(line, line_end - line);
+				line = line_end + (line_end != end);
+			}
+
+			size = end - line;
+			memmove(block.data(), line, size);
+
+			if (is_end)
+				return is_ok;
+		}
+	}
+
+}
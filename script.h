@@ -0,0 +1,55 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <cstddef>
+#include <cstdio>
+
+#include "context.h"
+
+
+namespace Math_solver {
+
+	// Whole file mapped read-only into memory, scripts are lexed in place
+	// instead of being read line by line.
+	class MappedFile
+	{
+	private:
+		const char* data_;
+		size_t size_;
+#if defined(_WIN32)
+		void* file_;
+		void* mapping_;
+#endif
+
+	public:
+		explicit MappedFile(const char* path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* get_data() const { return data_; }
+		size_t get_size() const { return size_; }
+	};
+
+	enum OutputFormat
+	{
+		OUTPUT_TEXT,	// one line per result
+		OUTPUT_BINARY	// one record per result (see output.h)
+	};
+
+	// Runs every non-empty line of "source" as one statement (assignment or
+	// expression), each is parsed and evaluated once, in order. Results are
+	// written to "output" one per line; the first error stops the script and
+	// is reported with its line number. Returns false on error.
+	bool Run_script(const char* source, size_t length, Context& context, FILE* output, OutputFormat format = OUTPUT_TEXT);
+
+	// Same for lines read from "input" in large blocks until its end, but an
+	// error is reported in place of the line's result and the rest still
+	// runs. Output is written in blocks, not per line. Returns false if any
+	// line failed.
+	bool Run_pipe(FILE* input, FILE* output, Context& context, OutputFormat format = OUTPUT_TEXT);
+
+}
+
+#endif // !SCRIPT_H
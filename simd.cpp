@@ -0,0 +1,283 @@
+#include "simd.h"
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX
+#else
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+
+namespace Math_solver {
+
+	// every kernel is a template of its operation, so the loops hold no dispatch
+
+	// portable fallback
+
+	template<ElementOp OP>
+	static void Scalar_vector_vector(const double* a, const double* b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+			for (unsigned int i = 0; i < 4; i++)
+				out[block + i] = (i < num_lanes) ? Simd_element<OP>(a[block + i], b[block + i]) : 0.0;
+	}
+
+	template<ElementOp OP>
+	static void Scalar_vector_scalar(const double* a, double b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+			for (unsigned int i = 0; i < 4; i++)
+				out[block + i] = (i < num_lanes) ? Simd_element<OP>(a[block + i], b) : 0.0;
+	}
+
+#ifdef SIMD_X86
+
+	// masks of computed lanes, indexed by "num_lanes"
+	alignas(32) static const int64_t lane_masks[5][4] =
+	{
+		{ 0, 0, 0, 0 },
+		{ -1, 0, 0, 0 },
+		{ -1, -1, 0, 0 },
+		{ -1, -1, -1, 0 },
+		{ -1, -1, -1, -1 }
+	};
+
+	// SSE2 (every x86-64 CPU), two lanes per register
+
+	template<ElementOp OP>
+	SIMD_TARGET_SSE2 static inline __m128d Sse2_op(__m128d a, __m128d b)
+	{
+		switch (OP)
+		{
+		case ELEMENT_ADD: return _mm_add_pd(a, b);
+		case ELEMENT_SUBTRACT: return _mm_sub_pd(a, b);
+		case ELEMENT_MULTIPLY: return _mm_mul_pd(a, b);
+		case ELEMENT_DIVIDE: return _mm_div_pd(a, b);
+		case ELEMENT_SUBTRACT_REVERSED: return _mm_sub_pd(b, a);
+		case ELEMENT_DIVIDE_REVERSED: return _mm_div_pd(b, a);
+		default: return _mm_setzero_pd();
+		}
+	}
+
+	template<ElementOp OP>
+	SIMD_TARGET_SSE2 static void Sse2_vector_vector(const double* a, const double* b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		const __m128d mask_low = _mm_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]));
+		const __m128d mask_high = _mm_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]) + 2);
+
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+		{
+			__m128d low = Sse2_op<OP>(_mm_loadu_pd(a + block), _mm_loadu_pd(b + block));
+			_mm_storeu_pd(out + block, _mm_and_pd(low, mask_low));
+
+			if (num_lanes > 2) {
+				__m128d high = Sse2_op<OP>(_mm_loadu_pd(a + block + 2), _mm_loadu_pd(b + block + 2));
+				_mm_storeu_pd(out + block + 2, _mm_and_pd(high, mask_high));
+			}
+			else
+				_mm_storeu_pd(out + block + 2, _mm_setzero_pd());
+		}
+	}
+
+	template<ElementOp OP>
+	SIMD_TARGET_SSE2 static void Sse2_vector_scalar(const double* a, double b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		const __m128d mask_low = _mm_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]));
+		const __m128d mask_high = _mm_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]) + 2);
+		const __m128d scalar = _mm_set1_pd(b);
+
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+		{
+			__m128d low = Sse2_op<OP>(_mm_loadu_pd(a + block), scalar);
+			_mm_storeu_pd(out + block, _mm_and_pd(low, mask_low));
+
+			if (num_lanes > 2) {
+				__m128d high = Sse2_op<OP>(_mm_loadu_pd(a + block + 2), scalar);
+				_mm_storeu_pd(out + block + 2, _mm_and_pd(high, mask_high));
+			}
+			else
+				_mm_storeu_pd(out + block + 2, _mm_setzero_pd());
+		}
+	}
+
+	// AVX, whole block in one register
+
+	template<ElementOp OP>
+	SIMD_TARGET_AVX static inline __m256d Avx_op(__m256d a, __m256d b)
+	{
+		switch (OP)
+		{
+		case ELEMENT_ADD: return _mm256_add_pd(a, b);
+		case ELEMENT_SUBTRACT: return _mm256_sub_pd(a, b);
+		case ELEMENT_MULTIPLY: return _mm256_mul_pd(a, b);
+		case ELEMENT_DIVIDE: return _mm256_div_pd(a, b);
+		case ELEMENT_SUBTRACT_REVERSED: return _mm256_sub_pd(b, a);
+		case ELEMENT_DIVIDE_REVERSED: return _mm256_div_pd(b, a);
+		default: return _mm256_setzero_pd();
+		}
+	}
+
+	template<ElementOp OP>
+	SIMD_TARGET_AVX static void Avx_vector_vector(const double* a, const double* b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		const __m256d mask = _mm256_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]));
+
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+		{
+			__m256d result = Avx_op<OP>(_mm256_loadu_pd(a + block), _mm256_loadu_pd(b + block));
+			_mm256_storeu_pd(out + block, _mm256_and_pd(result, mask));
+		}
+	}
+
+	template<ElementOp OP>
+	SIMD_TARGET_AVX static void Avx_vector_scalar(const double* a, double b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		const __m256d mask = _mm256_load_pd(reinterpret_cast<const double*>(lane_masks[num_lanes]));
+		const __m256d scalar = _mm256_set1_pd(b);
+
+		for (unsigned int block = 0; block < num_blocks * 4; block += 4)
+		{
+			__m256d result = Avx_op<OP>(_mm256_loadu_pd(a + block), scalar);
+			_mm256_storeu_pd(out + block, _mm256_and_pd(result, mask));
+		}
+	}
+
+	static bool Has_sse2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2") != 0;
+#endif
+	}
+
+	static bool Has_avx()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 1);
+
+		bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6; // OSXSAVE, XMM + YMM state
+		return os_saves_ymm && (info[2] & (1 << 28)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") != 0;
+#endif
+	}
+
+#endif // SIMD_X86
+
+	struct kernels_t
+	{
+		vector_vector_kernel_t vector_vector[NUM_ELEMENT_OPS];
+		vector_scalar_kernel_t vector_scalar[NUM_ELEMENT_OPS];
+		const char* instruction_set;
+	};
+
+	static kernels_t Kernels_of(InstructionSet set)
+	{
+		switch (set)
+		{
+#ifdef SIMD_X86
+		case SIMD_AVX:
+			return { SIMD_ELEMENT_OPS(Avx_vector_vector), SIMD_ELEMENT_OPS(Avx_vector_scalar), "avx" };
+		case SIMD_SSE2:
+			return { SIMD_ELEMENT_OPS(Sse2_vector_vector), SIMD_ELEMENT_OPS(Sse2_vector_scalar), "sse2" };
+#endif
+		default:
+			return { SIMD_ELEMENT_OPS(Scalar_vector_vector), SIMD_ELEMENT_OPS(Scalar_vector_scalar), "scalar" };
+		}
+	}
+
+	bool Simd_is_supported(InstructionSet set)
+	{
+		switch (set)
+		{
+		case SIMD_SCALAR:
+			return true;
+#ifdef SIMD_X86
+		case SIMD_SSE2:
+			return Has_sse2();
+		case SIMD_AVX:
+			return Has_avx();
+#endif
+		default:
+			return false;
+		}
+	}
+
+	// selected once, at startup
+	static kernels_t Select_kernels()
+	{
+		if (Simd_is_supported(SIMD_AVX))
+			return Kernels_of(SIMD_AVX);
+
+		if (Simd_is_supported(SIMD_SSE2))
+			return Kernels_of(SIMD_SSE2);
+
+		return Kernels_of(SIMD_SCALAR);
+	}
+
+	static const kernels_t& Get_kernels()
+	{
+		static const kernels_t kernels = Select_kernels();
+
+		return kernels;
+	}
+
+	static const kernels_t& Get_kernels(InstructionSet set)
+	{
+		static const kernels_t kernels[NUM_INSTRUCTION_SETS] = { Kernels_of(SIMD_SCALAR), Kernels_of(SIMD_SSE2), Kernels_of(SIMD_AVX) };
+
+		return kernels[set];
+	}
+
+	vector_vector_kernel_t Simd_vector_vector_kernel(ElementOp op, InstructionSet set)
+	{
+		return Get_kernels(set).vector_vector[op];
+	}
+
+	vector_scalar_kernel_t Simd_vector_scalar_kernel(ElementOp op, InstructionSet set)
+	{
+		return Get_kernels(set).vector_scalar[op];
+	}
+
+	vector_vector_kernel_t Simd_vector_vector_kernel(ElementOp op)
+	{
+		return Get_kernels().vector_vector[op];
+	}
+
+	vector_scalar_kernel_t Simd_vector_scalar_kernel(ElementOp op)
+	{
+		return Get_kernels().vector_scalar[op];
+	}
+
+	void Simd_vector_vector(ElementOp op, const double* a, const double* b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		Get_kernels().vector_vector[op](a, b, out, num_blocks, num_lanes);
+	}
+
+	void Simd_vector_scalar(ElementOp op, const double* a, double b, double* out, unsigned int num_blocks, unsigned int num_lanes)
+	{
+		Get_kernels().vector_scalar[op](a, b, out, num_blocks, num_lanes);
+	}
+
+	const char* Simd_get_instruction_set()
+	{
+		return Get_kernels().instruction_set;
+	}
+
+}
@@ -0,0 +1,564 @@
+#ifndef STATIC_EXPRESSION_H
+#define STATIC_EXPRESSION_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "functions.h"
+#include "operations.h"
+#include "error.h"
+
+
+// Expression parsed while compiling, "source" must be a string literal:
+//
+//     auto f = MS_EXPR("sin(x)*2 + 1");
+//     double y = f(0.5);
+//
+// Grammar is the one of Parser, restricted to scalars: numbers, constants,
+// + - * / % ^ !, signs of operands (-x^2 is (-x)^2 as in Parser) and the
+// one-parameter scalar functions. Any other name is
+// a variable, bound to the call arguments in order of first appearance.
+// Syntax errors are compile errors; run-time errors (division by zero, ...)
+// are thrown as by Parser.
+#define MS_EXPR(source) \
+	(::Math_solver::Static_expression([] { \
+		struct source_t { \
+			static constexpr const char* text() { return source; } \
+			static constexpr size_t length() { return sizeof(source) - 1; } \
+		}; \
+		return source_t(); \
+	}()))
+
+
+namespace Math_solver {
+
+	enum StaticNodeKind
+	{
+		STATIC_NUMBER,
+		STATIC_TEXT_NUMBER, // not exactly convertible while compiling, parsed once at run time
+		STATIC_VARIABLE,
+		STATIC_OPERATOR,
+		STATIC_NEGATE, // sign of an operand other than a number
+		STATIC_FUNCTION
+	};
+
+	typedef struct static_node {
+		StaticNodeKind kind = STATIC_NUMBER;
+		char oper = 0;
+		TokenType function = NONE;
+		unsigned int index = 0; // of variable, or of literal's first character
+		unsigned int length = 0; // of literal
+		unsigned int operands[2] = { 0, 0 };
+		double value = 0.0;
+	} static_node_t;
+
+	typedef struct static_variable {
+		unsigned int begin = 0;
+		unsigned int length = 0;
+	} static_variable_t;
+
+	// Post-order nodes of a source of "Length" characters - every node takes
+	// at least one character, so none can overflow.
+	template <size_t Length>
+	struct StaticTree
+	{
+		static_node_t nodes[Length + 1];
+		unsigned int num_nodes = 0;
+		unsigned int root = 0;
+
+		static_variable_t variables[Length + 1];
+		unsigned int num_variables = 0;
+	};
+
+	// Not constexpr: reaching it while compiling stops the compilation, the
+	// message is shown in the compiler's backtrace.
+	inline void Static_syntax_error(const char* message)
+	{
+		Throw_error(__FILE__, __LINE__, __func__, "%s", message);
+	}
+
+	constexpr bool Static_is_digit(char c) { return c >= '0' && c <= '9'; }
+	constexpr bool Static_is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+	constexpr bool Static_is_alnum(char c) { return Static_is_digit(c) || Static_is_alpha(c); }
+	constexpr bool Static_is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+	// Parser's grammar (AddSubtract, Term, Power, Primary) evaluated by the
+	// compiler; each rule returns the index of the node it has added.
+	template <size_t Length>
+	class StaticParser
+	{
+	private:
+		const char* source_;
+		size_t position_ = 0;
+		size_t word_start_ = 0;
+
+		TokenType type_ = NONE;
+		static_node_t number_;
+		unsigned int variable_index_ = 0;
+
+		StaticTree<Length> tree_;
+
+		constexpr bool IsAtEnd() const { return position_ == Length; }
+
+		constexpr char Next(size_t offset) const { return position_ + offset < Length ? source_[position_ + offset] : 0; }
+
+		constexpr void SkipSpaces()
+		{
+			while (!IsAtEnd() && Static_is_space(source_[position_]))
+				++position_;
+		}
+
+		constexpr bool IsWord(size_t begin, size_t length, const char* name, size_t name_length) const
+		{
+			if (length != name_length)
+				return false;
+
+			for (size_t i = 0; i < length; i++)
+				if (source_[begin + i] != name[i])
+					return false;
+
+			return true;
+		}
+
+		// same literals as Parse_number; exact values are converted here
+		constexpr void ParseNumber()
+		{
+			bool is_negative = (source_[position_] == '-');
+
+			if (source_[position_] == '+' || source_[position_] == '-')
+				++position_;
+
+			unsigned int base = 10;
+
+			if (Next(0) == '0')
+			{
+				switch (Next(1))
+				{
+				case 'b': case 'B': base = 2; break;
+				case 'o': case 'O': base = 8; break;
+				case 'x': case 'X': base = 16; break;
+				}
+			}
+
+			number_ = static_node_t();
+
+			if (base != 10) // integer with prefix
+			{
+				size_t digits = position_ += 2;
+				uint64_t integer = 0;
+
+				for (; !IsAtEnd() && Static_is_alnum(source_[position_]); ++position_)
+				{
+					char c = source_[position_];
+					unsigned int digit = Static_is_digit(c) ? c - '0' : (c >= 'a' ? c - 'a' : c - 'A') + 10;
+
+					if (digit >= base || integer > (UINT64_MAX - digit) / base)
+						Static_syntax_error("Bad numeric literal");
+
+					integer = integer * base + digit;
+				}
+
+				if (position_ == digits)
+					Static_syntax_error("Bad numeric literal");
+
+				number_.value = is_negative ? -(double)integer : (double)integer;
+				return;
+			}
+
+			// mantissa and power of ten are exact doubles up to 2^53 and 10^22,
+			// so is their correctly rounded quotient
+			uint64_t mantissa = 0;
+			unsigned int num_digits = 0, num_decimals = 0, num_points = 0;
+
+			for (; !IsAtEnd() && (Static_is_digit(source_[position_]) || source_[position_] == '.'); ++position_)
+			{
+				if (source_[position_] == '.') {
+					num_points++;
+					continue;
+				}
+
+				if (num_points != 0)
+					num_decimals++;
+
+				if (mantissa != 0 || source_[position_] != '0')
+					num_digits++;
+
+				if (num_digits <= 19)
+					mantissa = mantissa * 10 + (source_[position_] - '0');
+			}
+
+			if (num_points > 1)
+				Static_syntax_error("Bad numeric literal");
+
+			if (num_digits <= 19 && (num_decimals == 0 || (mantissa <= (1ull << 53) && num_decimals < NUM_POWERS_OF_10)))
+			{
+				double value = num_decimals == 0 ? (double)mantissa : (double)mantissa / POWERS_OF_10[num_decimals];
+				number_.value = is_negative ? -value : value;
+			}
+			else {
+				number_.kind = STATIC_TEXT_NUMBER;
+				number_.index = (unsigned int)word_start_;
+				number_.length = (unsigned int)(position_ - word_start_);
+			}
+		}
+
+		constexpr TokenType GetToken(const bool ignoreSign = false)
+		{
+			SkipSpaces();
+
+			word_start_ = position_;
+
+			if (IsAtEnd() && type_ == END)
+				Static_syntax_error("Unexpected end of expression.");
+
+			if (IsAtEnd())
+				return type_ = END;
+
+			char first = Next(0);
+			char next = Next(1);
+
+			if ((!ignoreSign && (first == '+' || first == '-') && (Static_is_digit(next) || next == '.'))
+				|| Static_is_digit(first)
+				|| (first == '.' && Static_is_digit(next)))
+			{
+				ParseNumber();
+				return type_ = SCALAR;
+			}
+
+			switch (first)
+			{
+			case '+':
+			case '-':
+			case '*':
+			case '/':
+			case '%':
+			case '!':
+			case '^':
+			case '(':
+			case ')':
+			case ',':
+				++position_;
+				return type_ = TokenType(first);
+			}
+
+			if (!Static_is_alpha(first))
+				Static_syntax_error("Unexpected character");
+
+			while (!IsAtEnd() && (Static_is_alnum(source_[position_]) || source_[position_] == '_'))
+				++position_;
+
+			size_t length = position_ - word_start_;
+
+			// check functions
+			for (const builtin_function_t& function : BUILTIN_FUNCTIONS)
+			{
+				if (!IsWord(word_start_, length, function.name, function.length))
+					continue;
+
+				if (function.token == RAND_FN)
+					Static_syntax_error("rand() needs an evaluation context, use Parser");
+
+				if (function.token < RAD_FN || function.token > SQRT_FN)
+					Static_syntax_error("Only scalar functions are supported");
+
+				return type_ = function.token;
+			}
+
+			SkipSpaces();
+
+			if (!IsAtEnd() && source_[position_] == '=')
+				Static_syntax_error("Assignments need an evaluation context, use Parser");
+
+			// check constants
+			for (const builtin_constant_t& constant : BUILTIN_CONSTANTS)
+			{
+				if (IsWord(word_start_, length, constant.name, constant.length)) {
+					number_ = static_node_t();
+					number_.value = constant.value;
+					return type_ = SCALAR;
+				}
+			}
+
+			// variables are numbered by first appearance
+			for (variable_index_ = 0; variable_index_ < tree_.num_variables; variable_index_++)
+			{
+				const static_variable_t& variable = tree_.variables[variable_index_];
+
+				if (IsWord(word_start_, length, source_ + variable.begin, variable.length))
+					return type_ = VARIABLE_PARAMETER;
+			}
+
+			tree_.variables[variable_index_].begin = (unsigned int)word_start_;
+			tree_.variables[variable_index_].length = (unsigned int)length;
+			tree_.num_variables++;
+
+			return type_ = VARIABLE_PARAMETER;
+		}
+
+		constexpr void CheckToken(const TokenType wanted)
+		{
+			if (type_ != wanted)
+				Static_syntax_error(wanted == LHPAREN ? "Expected: (" : "Expected: )");
+		}
+
+		constexpr unsigned int Add(const static_node_t& node)
+		{
+			tree_.nodes[tree_.num_nodes] = node;
+			return tree_.num_nodes++;
+		}
+
+		constexpr unsigned int AddOperator(char oper, unsigned int left, unsigned int right)
+		{
+			static_node_t node;
+			node.kind = STATIC_OPERATOR;
+			node.oper = oper;
+			node.operands[0] = left;
+			node.operands[1] = right;
+
+			return Add(node);
+		}
+
+		constexpr unsigned int AddFunction(TokenType function, unsigned int parameter)
+		{
+			static_node_t node;
+			node.kind = STATIC_FUNCTION;
+			node.function = function;
+			node.operands[0] = parameter;
+
+			return Add(node);
+		}
+
+		constexpr unsigned int Primary(const bool get)
+		{
+			if (get)
+				GetToken();
+
+			if (type_ == SCALAR)
+			{
+				unsigned int number = Add(number_);
+				GetToken(true);
+				return number;
+			}
+
+			if (type_ == VARIABLE_PARAMETER)
+			{
+				static_node_t node;
+				node.kind = STATIC_VARIABLE;
+				node.index = variable_index_;
+
+				GetToken(true);
+				return Add(node);
+			}
+
+			if (type_ == MINUS) // the sign of a number is part of its literal
+			{
+				static_node_t node;
+				node.kind = STATIC_NEGATE;
+				node.operands[0] = Primary(true);
+
+				return Add(node);
+			}
+
+			if (type_ == LHPAREN)
+			{
+				unsigned int inner = AddSubtract(true);
+				CheckToken(RHPAREN);
+				GetToken(true);
+				return inner;
+			}
+
+			if (type_ >= RAD_FN && type_ <= SQRT_FN) // one parameter function
+			{
+				TokenType function = type_;
+
+				GetToken(true);
+				CheckToken(LHPAREN);
+
+				unsigned int parameter = AddSubtract(true);
+
+				CheckToken(RHPAREN);
+				GetToken(true);
+
+				return AddFunction(function, parameter);
+			}
+
+			Static_syntax_error("Unexpected token");
+			return 0;
+		}
+
+		constexpr unsigned int Power(const bool get)
+		{
+			unsigned int left = Primary(get);
+
+			while (true)
+			{
+				if (type_ == POW)
+					left = AddOperator('^', left, Primary(true));
+				else if (type_ == FACTORIAL) {
+					left = AddFunction(FACTORIAL, left);
+					GetToken(true);
+				}
+				else
+					return left;
+			}
+		}
+
+		constexpr unsigned int Term(const bool get)
+		{
+			unsigned int left = Power(get);
+
+			while (type_ == MULTIPLY || type_ == DIVIDE || type_ == MODULO)
+			{
+				char oper = (char)type_;
+				left = AddOperator(oper, left, Power(true));
+			}
+
+			return left;
+		}
+
+		constexpr unsigned int AddSubtract(const bool get)
+		{
+			unsigned int left = Term(get);
+
+			while (type_ == PLUS || type_ == MINUS)
+			{
+				char oper = (char)type_;
+				left = AddOperator(oper, left, Term(true));
+			}
+
+			return left;
+		}
+
+	public:
+		constexpr explicit StaticParser(const char* source)
+			: source_(source)
+		{
+		}
+
+		constexpr StaticTree<Length> Parse()
+		{
+			GetToken();
+
+			tree_.root = AddSubtract(false);
+
+			if (type_ != END)
+				Static_syntax_error("Unexpected text at the end of expression");
+
+			return tree_;
+		}
+	};
+
+	// literal which couldn't be converted exactly while compiling
+	inline double Static_number(const char* text, size_t length)
+	{
+		double value = 0.0;
+		Parse_number(text, text + length, value);
+		return value;
+	}
+
+	template <char Oper>
+	inline double Static_oper(double left, double right)
+	{
+		if constexpr (Oper == '+')
+			return left + right;
+		else if constexpr (Oper == '-')
+			return left - right;
+		else if constexpr (Oper == '*')
+			return left * right;
+		else if constexpr (Oper == '/') {
+			if (right == 0.0)
+				Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+
+			return left / right;
+		}
+		else
+			return Scalar_oper(Oper, left, right);
+	}
+
+	// same functions as Scalar_function
+	template <TokenType Function>
+	inline double Static_function(double x)
+	{
+		if constexpr (Function == RAD_FN) return Radians(x);
+		else if constexpr (Function == DEG_FN) return Degrees(x);
+		else if constexpr (Function == SIN_FN) return sin(x);
+		else if constexpr (Function == COS_FN) return cos(x);
+		else if constexpr (Function == TAN_FN) return tan(x);
+		else if constexpr (Function == SINH_FN) return sinh(x);
+		else if constexpr (Function == COSH_FN) return cosh(x);
+		else if constexpr (Function == TANH_FN) return tanh(x);
+		else if constexpr (Function == ASIN_FN) return asin(x);
+		else if constexpr (Function == ACOS_FN) return acos(x);
+		else if constexpr (Function == ATAN_FN) return atan(x);
+		else if constexpr (Function == ABS_FN) return fabs(x);
+		else if constexpr (Function == LN_FN) return log(x);
+		else if constexpr (Function == LOG_FN) return log10(x);
+		else if constexpr (Function == EXP_FN) return exp(x);
+		else if constexpr (Function == SQRT_FN) return sqrt(x);
+		else return Factorial(x);
+	}
+
+	// Expression of MS_EXPR, every node is a separate instantiation of
+	// evaluate() so the compiler sees the whole expression at once.
+	template <typename Source>
+	class StaticExpression
+	{
+	private:
+		static constexpr StaticTree<Source::length()> tree_ = StaticParser<Source::length()>(Source::text()).Parse();
+
+		// parses the source as soon as MS_EXPR is used, not at the first call
+		static_assert(tree_.num_nodes != 0, "Empty expression");
+
+		template <unsigned int Node>
+		static double evaluate(const double* variables)
+		{
+			constexpr static_node_t node = tree_.nodes[Node];
+
+			if constexpr (node.kind == STATIC_NUMBER)
+				return node.value;
+			else if constexpr (node.kind == STATIC_TEXT_NUMBER) {
+				static const double value = Static_number(Source::text() + node.index, node.length);
+				return value;
+			}
+			else if constexpr (node.kind == STATIC_VARIABLE)
+				return variables[node.index];
+			else if constexpr (node.kind == STATIC_NEGATE)
+				return -evaluate<node.operands[0]>(variables);
+			else if constexpr (node.kind == STATIC_OPERATOR) {
+				double left = evaluate<node.operands[0]>(variables);
+				return Static_oper<node.oper>(left, evaluate<node.operands[1]>(variables));
+			}
+			else
+				return Static_function<node.function>(evaluate<node.operands[0]>(variables));
+		}
+
+	public:
+		static constexpr unsigned int NUM_VARIABLES = tree_.num_variables;
+
+		// one value per variable, in order of first appearance
+		template <typename... Values>
+		double operator()(Values... values) const
+		{
+			static_assert(sizeof...(Values) == NUM_VARIABLES, "Wrong number of values for the expression's variables");
+
+			const double variables[] = { (double)values..., 0.0 };
+			return evaluate<tree_.root>(variables);
+		}
+
+		static constexpr std::string_view get_variable(unsigned int index)
+		{
+			return std::string_view(Source::text() + tree_.variables[index].begin, tree_.variables[index].length);
+		}
+	};
+
+	template <typename Source>
+	constexpr StaticExpression<Source> Static_expression(Source)
+	{
+		return StaticExpression<Source>();
+	}
+
+}
+
+#endif // !STATIC_EXPRESSION_H
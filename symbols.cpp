@@ -0,0 +1,32 @@
+#include "symbols.h"
+
+
+namespace Math_solver {
+
+	bool SymbolTable::find(std::string_view name, unsigned int& index) const
+	{
+		auto search = indices_.find(name);
+
+		if (search == indices_.end())
+			return false;
+
+		index = search->second;
+		return true;
+	}
+
+	unsigned int SymbolTable::add(std::string_view name)
+	{
+		unsigned int index;
+
+		if (find(name, index))
+			return index;
+
+		index = (unsigned int)slots_.size();
+
+		slots_.push_back(value_t());
+		indices_.emplace(name, index);
+
+		return index;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.h"
+
+
+namespace Math_solver {
+
+	// Variables are stored as typed slots. Names are resolved to slot indices
+	// while parsing, evaluation only indexes into the slot vector.
+	class SymbolTable
+	{
+	private:
+		std::map<std::string, unsigned int, std::less<>> indices_; // looked up by views into the source
+		std::vector<value_t> slots_;
+
+	public:
+		bool find(std::string_view name, unsigned int& index) const;
+		unsigned int add(std::string_view name); // returns existing slot if already defined
+
+		void set(std::string_view name, const value_t& value)
+		{
+			slots_[add(name)] = value;
+		}
+
+		std::vector<value_t>* get_slots() { return &slots_; }
+		unsigned int size() const { return (unsigned int)slots_.size(); }
+	};
+
+}
+
+#endif // !SYMBOLS_H
@@ -0,0 +1,244 @@
+// Batch evaluation - every row of evaluate_batch must be what evaluate()
+// returns for the same bindings, for scalar, vector and matrix columns, and
+// the parallel evaluate_batch must write what the single-threaded one does.
+
+#include "parser.h"
+#include "scheduler.h"
+#include "checks.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+using namespace Math_solver;
+
+// compares rows of "output" with evaluate() of the bindings loaded from "columns"
+static void Compare_rows(const char* text, const CompiledExpression& expression, const std::vector<column_t>& columns,
+	size_t num_rows, const double* output, size_t output_stride)
+{
+	for (size_t row = 0; row < num_rows; row++)
+	{
+		Bindings bindings;
+
+		for (const column_t& column : columns)
+			bindings.push_back(column.load(row));
+
+		double expected[16];
+		unsigned int num_components = Store_value(expression.evaluate(bindings), expected, 16);
+
+		for (unsigned int i = 0; i < num_components; i++)
+		{
+			if (output[row * output_stride + i] != expected[i])
+			{
+				Report_failure("batch \"%s\" row %zu component %u is %.17g instead of %.17g", text, row, i, output[row * output_stride + i], expected[i]);
+				return;
+			}
+		}
+	}
+}
+
+// "x" is a scalar column, "y" the same value in every row (stride 0)
+static void Check_scalar_columns()
+{
+	const char* text = "x * 2 + y / 4 - sin(x)";
+	const size_t NUM_ROWS = 100;
+	const double y = 3.0;
+
+	std::vector<double> x(NUM_ROWS);
+
+	for (size_t row = 0; row < NUM_ROWS; row++)
+		x[row] = row * 0.25 - 10.0;
+
+	Context context(1);
+	Parser parser(text, context);
+	CompiledExpression expression = parser.Compile({ "x", "y" }, { shape_t::scalar(), shape_t::scalar() });
+
+	std::vector<column_t> columns = { column_t::scalar(x.data()), column_t::scalar(&y, 0) };
+
+	// every other double of the output is left alone
+	const double UNTOUCHED = -12345.0;
+	std::vector<double> output(NUM_ROWS * 2, UNTOUCHED);
+
+	expression.evaluate_batch(columns, NUM_ROWS, output.data(), 2);
+	Compare_rows(text, expression, columns, NUM_ROWS, output.data(), 2);
+
+	for (size_t row = 0; row < NUM_ROWS; row++)
+	{
+		if (output[row * 2 + 1] != UNTOUCHED)
+		{
+			Report_failure("batch \"%s\" wrote between rows of output stride 2", text);
+			return;
+		}
+	}
+}
+
+// vec3 rows padded to 4 doubles, result is a vec3
+static void Check_vector_columns()
+{
+	const char* text = "v * 2 - w + 1";
+	const size_t NUM_ROWS = 50;
+	const double w[3] = { 0.5, -1.0, 2.0 };
+
+	std::vector<double> v(NUM_ROWS * 4);
+
+	for (size_t i = 0; i < v.size(); i++)
+		v[i] = (double)i / 3.0;
+
+	Context context(1);
+	Parser parser(text, context);
+	CompiledExpression expression = parser.Compile({ "v", "w" }, { shape_t::vector(3), shape_t::vector(3) });
+
+	std::vector<column_t> columns = { column_t::vector(v.data(), 3, 4), column_t::vector(w, 3, 0) };
+	std::vector<double> output(NUM_ROWS * 3);
+
+	expression.evaluate_batch(columns, NUM_ROWS, output.data(), 3);
+	Compare_rows(text, expression, columns, NUM_ROWS, output.data(), 3);
+
+	if (output[3 * 7 + 1] != v[4 * 7 + 1] * 2.0 - w[1] + 1.0)
+		Report_failure("batch \"%s\" row 7 is %g", text, output[3 * 7 + 1]);
+}
+
+// mat2 rows in column-major order, result is a mat2
+static void Check_matrix_columns()
+{
+	const char* text = "m * 3 - s";
+	const size_t NUM_ROWS = 40;
+
+	std::vector<double> m(NUM_ROWS * 4);
+	std::vector<double> s(NUM_ROWS);
+
+	for (size_t i = 0; i < m.size(); i++)
+		m[i] = (double)(i % 11) - 5.0;
+
+	for (size_t row = 0; row < NUM_ROWS; row++)
+		s[row] = (double)row;
+
+	Context context(1);
+	Parser parser(text, context);
+	CompiledExpression expression = parser.Compile({ "m", "s" }, { shape_t::matrix(2), shape_t::scalar() });
+
+	std::vector<column_t> columns = { column_t::matrix(m.data(), 2, 4), column_t::scalar(s.data()) };
+	std::vector<double> output(NUM_ROWS * 4);
+
+	expression.evaluate_batch(columns, NUM_ROWS, output.data(), 4);
+	Compare_rows(text, expression, columns, NUM_ROWS, output.data(), 4);
+
+	// column 1, row 0 of the matrix of row 9
+	if (output[4 * 9 + 2] != m[4 * 9 + 2] * 3.0 - s[9])
+		Report_failure("batch \"%s\" row 9 is %g", text, output[4 * 9 + 2]);
+}
+
+// columns of the wrong shape are rejected before any row runs
+static void Check_column_shapes()
+{
+	const double data[4] = { 1.0, 2.0, 3.0, 4.0 };
+	double output[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+	Context context(1);
+	Parser parser("v + 1", context);
+	CompiledExpression expression = parser.Compile({ "v" }, { shape_t::vector(2) });
+
+	try
+	{
+		expression.evaluate_batch({ column_t::vector(data, 3, 3) }, 1, output, 3);
+		Report_failure("batch accepted a vec3 column for a vec2 parameter");
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+// single-threaded results of "text" over "x", in the first stream of a context of seed 1
+static std::vector<double> Evaluate_serial(const char* text, const std::vector<double>& x)
+{
+	Context context(1);
+	Parser parser(text, context);
+	CompiledExpression expression = parser.Compile({ "x" }, { shape_t::scalar() });
+
+	std::vector<double> output(x.size());
+	expression.evaluate_batch({ column_t::scalar(x.data()) }, x.size(), output.data(), 1);
+
+	return output;
+}
+
+// rows of uneven cost (factorial) and rand(), which is keyed by row and not by thread
+static unsigned int Check_parallel()
+{
+	const char* text = "x * rand(999) + (x % 7 + 1)! - sin(x) * rand(10)";
+	const size_t NUM_ROWS = 10000;
+	const size_t CHUNK_ROWS[] = { 1, 7, 256, 5000, 20000 };
+
+	std::vector<double> x(NUM_ROWS);
+
+	for (size_t row = 0; row < NUM_ROWS; row++)
+		x[row] = (double)(row % 50);
+
+	std::vector<double> expected = Evaluate_serial(text, x);
+	unsigned int num_checks = 0;
+
+	for (unsigned int num_threads = 1; num_threads <= 8; num_threads *= 2)
+	{
+		Scheduler scheduler(num_threads);
+
+		for (size_t chunk_rows : CHUNK_ROWS)
+		{
+			Context context(1);
+			Parser parser(text, context);
+			CompiledExpression expression = parser.Compile({ "x" }, { shape_t::scalar() });
+
+			std::vector<double> output(NUM_ROWS, -1.0);
+			expression.evaluate_batch({ column_t::scalar(x.data()) }, NUM_ROWS, output.data(), 1, scheduler, chunk_rows);
+
+			if (memcmp(output.data(), expected.data(), NUM_ROWS * sizeof(double)) != 0)
+				Report_failure("parallel batch on %u threads, chunks of %zu rows differs from single-threaded", num_threads, chunk_rows);
+
+			num_checks++;
+		}
+	}
+
+	// the same seed gives the same numbers, another one doesn't
+	Context other(2);
+	Parser parser(text, other);
+	CompiledExpression expression = parser.Compile({ "x" }, { shape_t::scalar() });
+
+	std::vector<double> output(NUM_ROWS);
+	expression.evaluate_batch({ column_t::scalar(x.data()) }, NUM_ROWS, output.data(), 1);
+
+	if (memcmp(output.data(), expected.data(), NUM_ROWS * sizeof(double)) == 0 || Evaluate_serial(text, x) != expected)
+		Report_failure("rand() of a batch doesn't depend on the seed only");
+
+	return num_checks + 1;
+}
+
+// parallel batches don't run assignments, their stores would race
+static void Check_parallel_assignment()
+{
+	const double x = 1.0;
+	double output = 0.0;
+
+	Context context(1);
+	Scheduler scheduler(2);
+	Parser parser("a = x + 1", context);
+	CompiledExpression expression = parser.Compile({ "x" }, { shape_t::scalar() });
+
+	try
+	{
+		expression.evaluate_batch({ column_t::scalar(&x, 0) }, 10, &output, 1, scheduler);
+		Report_failure("parallel batch ran an assignment");
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+unsigned int Run_batch_checks()
+{
+	Check_scalar_columns();
+	Check_vector_columns();
+	Check_matrix_columns();
+	Check_column_shapes();
+	Check_parallel_assignment();
+
+	return 5 + Check_parallel();
+}
@@ -0,0 +1,32 @@
+#ifndef CHECKS_H
+#define CHECKS_H
+
+#include <cstdarg>
+#include <cstdio>
+
+
+// Shared by the files of tests/regression. Each Run_*_checks() returns how
+// many checks it has run; failures are printed and counted as they happen.
+extern int num_failed;
+
+inline void Report_failure(const char* fmt, ...)
+{
+	va_list va;
+
+	fputs("FAILED: ", stderr);
+	va_start(va, fmt);
+	vfprintf(stderr, fmt, va);
+	va_end(va);
+	fputc('\n', stderr);
+
+	num_failed++;
+}
+
+unsigned int Run_batch_checks();
+unsigned int Run_simd_checks();
+unsigned int Run_random_checks();
+unsigned int Run_jit_checks();
+unsigned int Run_format_checks();
+unsigned int Run_output_checks();
+
+#endif // !CHECKS_H
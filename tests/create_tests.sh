@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Builds the regression checks, run from the repository root with GLM in
+# ./glm (as cloned by create_solver.sh):
+#
+#   tests/create_tests.sh && tests/regression
+
+SOURCES=$(ls *.cpp | grep -v main.cpp)
+
+g++ -O2 -Wall -DNDEBUG -I./glm -I. tests/*.cpp $SOURCES -pthread -o tests/regression || exit 1
+
+echo "Done!"
@@ -0,0 +1,131 @@
+// Number formatting - Format_number and to_chars write into caller buffers,
+// but must give the text of the previous RoundOff, to_string and separator
+// code. Expected strings were produced by that code, except for NaN, which
+// it printed as "nan.nan".
+
+#include "operations.h"
+#include "types.h"
+#include "checks.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+
+using namespace Math_solver;
+
+typedef struct format_check {
+	double value;
+	unsigned int precision;
+	const char* expected;
+} format_check_t;
+
+static const format_check_t CHECKS[] =
+{
+	// zero and negative zero, signed as the previous code printed them
+	{ 0.0, 3, "0" },
+	{ -0.0, 3, "0" },
+	{ -0.0, 7, "0" },
+	{ -0.0004, 3, "0" },
+	{ -0.0004, 6, "-0.0004" },
+	{ -1e-7, 6, "0" },
+	{ -1e-7, 7, "-0" },
+	{ -0.5, 0, "-1" },
+
+	// around 2^33, where integer and decimal parts are split
+	{ 4294967296.0, 6, "4,294,967,296" },
+	{ 8589934592.0, 0, "8,589,934,592" },
+	{ 8589934591.5, 0, "8,589,934,592" },
+	{ 8589934591.5, 1, "8,589,934,591.5" },
+	{ 8589934592.25, 1, "8,589,934,592.299999" },
+	{ 8589934592.25, 3, "8,589,934,592.25" },
+	{ -8589934593.75, 0, "-8,589,934,594" },
+	{ -8589934593.75, 1, "-8,589,934,593.799999" },
+	{ 8589934591.999, 1, "8,589,934,592" },
+	{ 8589934591.999, 3, "8,589,934,591.999" },
+	{ 17179869184.125, 1, "17,179,869,184.099998" },
+	{ 17179869184.125, 9, "17,179,869,184.125" },
+
+	// rounding and separators
+	{ 999.9996, 3, "1,000" },
+	{ 999.9995, 6, "999.9995" },
+	{ -1000.0, 3, "-1,000" },
+	{ 1234567.891, 1, "1,234,567.9" },
+	{ -9876543.21, 3, "-9,876,543.21" },
+	{ 0.0005, 3, "0.001" },
+	{ 0.30000000000000004, 3, "0.3" },
+	{ -2.0 / 3.0, 3, "-0.667" },
+
+	// precision above six, only six decimals are shown
+	{ 123.456789, 7, "123.456789" },
+	{ 3.14159265358979, 9, "3.141593" },
+	{ 1.0 / 3.0, 12, "0.333333" },
+	{ 12345.6789012345, 9, "12,345.678901" },
+	{ 0.0004, 12, "0.0004" },
+	{ -1e-7, 12, "-0" },
+
+	// very large and very small magnitudes
+	{ 123456789012345.678, 0, "123,456,789,012,346" },
+	{ 123456789012345.678, 6, "123,456,789,012,345.671875" },
+	{ 1e17, 6, "99,999,999,999,999,984" },
+	{ 1e17, 7, "100,000,000,000,000,000" },
+	{ 1e22, 3, "10,000,000,000,000,000,000,000" },
+	{ 1e100, 0, "10,000,000,000,000,000,159,028,911,097,599,180,468,360,808,563,945,281,389,781,327,557,747,838,772,170,381,060,813,469,985,856,815,104" },
+	{ DBL_MAX, 0, "179,769,313,486,231,570,814,527,423,731,704,356,798,070,567,525,844,996,598,917,476,803,157,260,780,028,538,760,589,558,632,766,878,171,540,458,953,514,382,464,234,321,326,889,464,182,768,467,546,703,537,516,986,049,910,576,551,282,076,245,490,090,389,328,944,075,868,508,455,133,942,304,583,236,903,222,948,165,808,559,332,123,348,274,797,826,204,144,723,168,738,177,180,919,299,881,250,404,026,184,124,858,368" },
+	{ DBL_MAX, 1, "inf" },
+	{ 1e-300, 7, "0" },
+
+	// infinities and NaN
+	{ INFINITY, 3, "inf" },
+	{ -INFINITY, 0, "-inf" },
+	{ NAN, 6, "nan" },
+	{ NAN, 12, "nan" }
+};
+
+static void Check_number(const format_check_t& check)
+{
+	char buffer[NUMBER_STR_SIZE + 1];
+	size_t length = Format_number(check.value, check.precision, buffer);
+
+	if (length > NUMBER_STR_SIZE || std::string(buffer, length) != check.expected)
+		Report_failure("Format_number(%.17g, %u) is \"%.*s\" instead of \"%s\"", check.value, check.precision, (int)length, buffer, check.expected);
+	else if (Format_number(check.value, check.precision) != check.expected)
+		Report_failure("Format_number(%.17g, %u) as string is \"%s\"", check.value, check.precision, Format_number(check.value, check.precision).c_str());
+}
+
+// text of a vector or matrix, both through to_str and to_chars
+template<typename T>
+static void Check_value(const T& value, unsigned int precision, const char* expected)
+{
+	char buffer[VALUE_STR_SIZE];
+	size_t length = value.to_chars(buffer, precision);
+
+	if (std::string(buffer, length) != expected || value.to_str(precision) != expected)
+		Report_failure("value is \"%.*s\" instead of \"%s\"", (int)length, buffer, expected);
+}
+
+static void Check_separators()
+{
+	glm::dmat4 m(1.0);
+	m[0][1] = -1234.5678;
+	m[1][0] = 0.125;
+
+	Check_value(value_t(-1234567.125).vec, 2, "-1,234,567.13");
+	Check_value(value_t(glm::dvec4(-0.0, 3.0, 0.0, 0.0), 2).vec, 2, "( 0, 3 )");
+	Check_value(value_t(glm::dvec4(1.5, -2000.25, 0.0, 1e9), 4).vec, 3, "( 1.5, -2,000.25, 0, 1,000,000,000 )");
+	Check_value(value_t(glm::dmat4(1.0), 3).mat, 3, "\n( 1, 0, 0 )\n( 0, 1, 0 )\n( 0, 0, 1 )\n");
+	Check_value(value_t(m, 2).mat, 1, "\n( 1, -1,234.6 )\n( 0.1, 1 )\n");
+}
+
+unsigned int Run_format_checks()
+{
+	const unsigned int NUM_CHECKS = sizeof(CHECKS) / sizeof(CHECKS[0]);
+
+	for (const format_check_t& check : CHECKS)
+		Check_number(check);
+
+	Check_separators();
+
+	return NUM_CHECKS + 5;
+}
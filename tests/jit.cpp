@@ -0,0 +1,124 @@
+// Native code - every scalar program must return what the interpreter does,
+// bit for bit, over a grid of bindings, and fail where it fails (division
+// by zero). Without native code both sides run the interpreter.
+
+#include "parser.h"
+#include "checks.h"
+
+#include <cmath>
+#include <cstring>
+
+
+using namespace Math_solver;
+
+typedef struct jit_check {
+	const char* text;
+	bool is_native; // modulo and factorial throw, they never run natively
+} jit_check_t;
+
+static const jit_check_t CHECKS[] =
+{
+	{ "x + y", true },
+	{ "x - y * 2", true },
+	{ "x / y", true },
+	{ "(x + 1) / (y - 1)", true },
+	{ "x * y / (x - y)", true },
+	{ "-x + --y - -(x * y)", true },
+	{ "x ^ 2 + y ^ 3", true },
+	{ "2 ^ x / 8", true },
+	{ "sin(x) * cos(y) - tan(x / 4)", true },
+	{ "sqrt(abs(x)) + exp(y / 10) - ln(abs(y) + 1)", true },
+	{ "log(abs(x * y) + 1) * atan(y) + asin(x / 8) - acos(y / 8)", true },
+	{ "sinh(x / 2) - cosh(y / 2) + tanh(x * y)", true },
+	{ "RAD(x) + DEG(y)", true },
+	{ "((x + y) * (x - y) / ((x * x) + 1)) * 1 / y", true },
+	{ "x % 3 + y % 2", false },
+	{ "abs(x)! + 3! * y", false }
+};
+
+#if defined(__x86_64__) || defined(_M_X64)
+static const bool IS_JIT_PLATFORM = USE_JIT;
+#else
+static const bool IS_JIT_PLATFORM = false;
+#endif
+
+static const double GRID[] = { -3.0, -1.0, -0.5, 0.0, 0.5, 1.0, 2.0, 7.0 };
+
+static bool Is_same(double a, double b)
+{
+	return (std::isnan(a) && std::isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// result of "run" or its error
+template<typename F>
+static bool Run(F run, double& result)
+{
+	try
+	{
+		result = run();
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		result = 0.0;
+		return false;
+	}
+}
+
+static void Check_program(const jit_check_t& check)
+{
+	const char* text = check.text;
+
+	Context context(1);
+	Parser parser(text, context);
+	CompiledExpression expression = parser.Compile({ "x", "y" }, { shape_t::scalar(), shape_t::scalar() });
+	const Program* program = expression.get_program();
+
+	if (!program->is_scalar())
+	{
+		Report_failure("\"%s\" isn't a scalar program", text);
+		return;
+	}
+
+	if (program->is_native() != (check.is_native && IS_JIT_PLATFORM))
+		Report_failure("\"%s\" is%s native code", text, program->is_native() ? "" : "n't");
+
+	for (double x : GRID)
+	{
+		for (double y : GRID)
+		{
+			Bindings bindings = { value_t(x), value_t(y) };
+			const double scalars[2] = { x, y };
+			double expected, result, scalar;
+			bool is_doubles = true;
+
+			bool is_expected = Run([&]() { return program->run_interpreter(bindings.data(), bindings.size(), nullptr).vec.to_scalar(); }, expected);
+			bool is_result = Run([&]() { return program->run(bindings.data(), bindings.size(), nullptr).vec.to_scalar(); }, result);
+			bool is_scalar = Run([&]() {
+				double value = 0.0;
+				is_doubles = program->run(scalars, 2, value);
+
+				return value;
+			}, scalar);
+
+			if (!is_doubles)
+				Report_failure("\"%s\" didn't run on doubles", text);
+			else if (is_result != is_expected || is_scalar != is_expected)
+				Report_failure("\"%s\" x = %g, y = %g fails in %s only", text, x, y, is_expected ? "native code" : "the interpreter");
+			else if (!Is_same(result, expected) || !Is_same(scalar, expected))
+				Report_failure("\"%s\" x = %g, y = %g is %.17g (doubles %.17g) instead of %.17g", text, x, y, result, scalar, expected);
+			else
+				continue;
+
+			return;
+		}
+	}
+}
+
+unsigned int Run_jit_checks()
+{
+	for (const jit_check_t& check : CHECKS)
+		Check_program(check);
+
+	return sizeof(CHECKS) / sizeof(CHECKS[0]);
+}
@@ -0,0 +1,192 @@
+// Binary results - the byte layout of records (tag, little-endian doubles,
+// column-major matrices, error records) and of result columns, read back
+// byte by byte as a tool on any platform would.
+
+#include "output.h"
+#include "script.h"
+#include "checks.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+using namespace Math_solver;
+
+// little-endian bytes of "value", built without Write_little_endian
+static std::string Bytes_of(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	std::string bytes;
+
+	for (unsigned int i = 0; i < 8; i++)
+		bytes += (char)(unsigned char)(bits >> (8 * i));
+
+	return bytes;
+}
+
+static std::string Record(unsigned char tag, std::initializer_list<double> components)
+{
+	std::string record(1, (char)tag);
+
+	for (double component : components)
+		record += Bytes_of(component);
+
+	return record;
+}
+
+static std::string Error_record(const std::string& message)
+{
+	std::string record(1, (char)RESULT_ERROR);
+
+	for (unsigned int i = 0; i < 4; i++)
+		record += (char)(unsigned char)(message.size() >> (8 * i));
+
+	return record + message;
+}
+
+static std::string Read_all(FILE* file)
+{
+	std::string bytes;
+	char block[256];
+	size_t size;
+
+	rewind(file);
+
+	while ((size = fread(block, 1, sizeof(block), file)) > 0)
+		bytes.append(block, size);
+
+	return bytes;
+}
+
+static void Check_record(const char* name, const value_t& value, const std::string& expected)
+{
+	unsigned char buffer[RESULT_RECORD_SIZE];
+	size_t size = Write_result_record(value, buffer);
+
+	if (std::string((const char*)buffer, size) != expected)
+		Report_failure("record of %s differs in %zu bytes", name, size);
+}
+
+static void Check_records()
+{
+	glm::dmat4 m(1.0);
+	m[0][1] = 2.0; // column 0, row 1
+	m[1][0] = -3.5;
+
+	Check_record("2.5", value_t(2.5), Record(1, { 2.5 }));
+	Check_record("vec3", value_t(glm::dvec4(1.0, -2.0, 0.25, 9.0), 3), Record(3, { 1.0, -2.0, 0.25 }));
+	Check_record("mat2", value_t(m, 2), Record(RESULT_MATRIX | 2, { 1.0, 2.0, -3.5, 1.0 }));
+	Check_record("mat4", value_t(glm::dmat4(1.0), 4), Record(RESULT_MATRIX | 4,
+		{ 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 }));
+
+	if (Result_tag(shape_t::matrix(3)) != 0x13 || Result_tag(shape_t::vector(4)) != 0x04)
+		Report_failure("Result_tag of mat3 is %02x, of vec4 %02x", Result_tag(shape_t::matrix(3)), Result_tag(shape_t::vector(4)));
+
+	try
+	{
+		Result_tag(shape_t::unknown());
+		Report_failure("Result_tag accepted an unknown shape");
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+// vec2 rows of stride 3, as evaluate_batch would write them
+static void Check_columns()
+{
+	const double results[] = { 1.0, 2.0, -1.0, 3.0, 4.0, -1.0, 5.0, 6.0, -1.0 };
+
+	FILE* output = tmpfile();
+
+	if (output == nullptr)
+	{
+		Report_failure("Write_result_columns, no temporary file");
+		return;
+	}
+
+	Write_result_columns(output, shape_t::vector(2), results, 3, 3);
+
+	std::string expected(1, (char)2);
+
+	for (unsigned int i = 0; i < 8; i++)
+		expected += (char)(i == 0 ? 3 : 0); // number of rows
+
+	expected += Bytes_of(1.0) + Bytes_of(3.0) + Bytes_of(5.0) + Bytes_of(2.0) + Bytes_of(4.0) + Bytes_of(6.0);
+
+	if (Read_all(output) != expected)
+		Report_failure("Write_result_columns of vec2 rows differs");
+
+	try
+	{
+		Write_result_columns(output, shape_t::matrix(2), results, 2, 3);
+		Report_failure("Write_result_columns accepted mat2 rows of stride 3");
+	}
+	catch (const std::exception&)
+	{
+	}
+
+	fclose(output);
+}
+
+// --binary: one record per line with a result, errors in place
+static void Check_pipe()
+{
+	static const char INPUT[] = "1 + 1\nvec2(1, 2)\n()\na = 3\nmat2() * a\n";
+
+	FILE* input = tmpfile();
+	FILE* output = tmpfile();
+
+	if (input == nullptr || output == nullptr)
+	{
+		Report_failure("Run_pipe, no temporary files");
+		return;
+	}
+
+	fputs(INPUT, input);
+	rewind(input);
+
+	Context context(1);
+	bool is_ok = Run_pipe(input, output, context, OUTPUT_BINARY);
+	std::string bytes = Read_all(output);
+
+	std::string expected = Record(1, { 2.0 }) + Record(2, { 1.0, 2.0 });
+	std::string results = Record(RESULT_MATRIX | 2, { 3.0, 0.0, 0.0, 3.0 });
+
+	// the message is free text, only its framing is checked
+	size_t error_size = 0;
+
+	if (bytes.size() > expected.size() + 5 && (unsigned char)bytes[expected.size()] == RESULT_ERROR)
+	{
+		for (unsigned int i = 0; i < 4; i++)
+			error_size |= (size_t)(unsigned char)bytes[expected.size() + 1 + i] << (8 * i);
+	}
+
+	std::string message = bytes.substr(expected.size() + 5 < bytes.size() ? expected.size() + 5 : bytes.size(), error_size);
+	expected += Error_record(message) + results;
+
+	if (is_ok || error_size == 0 || message.compare(0, 8, "Line 3: ") != 0 || bytes != expected)
+	{
+		size_t offset = 0;
+
+		while (offset < bytes.size() && offset < expected.size() && bytes[offset] == expected[offset])
+			offset++;
+
+		Report_failure("Run_pipe --binary wrote %zu bytes, %zu expected, first difference at byte %zu", bytes.size(), expected.size(), offset);
+	}
+
+	fclose(input);
+	fclose(output);
+}
+
+unsigned int Run_output_checks()
+{
+	Check_records();
+	Check_columns();
+	Check_pipe();
+
+	return 3;
+}
@@ -0,0 +1,131 @@
+// Random streams - Philox4x32-10 against the known-answer vectors of its
+// authors (Random123), and rand() depending only on seed, stream and row.
+
+#include "random.h"
+#include "operations.h"
+#include "checks.h"
+
+#include <vector>
+
+
+using namespace Math_solver;
+
+typedef struct philox_case {
+	uint32_t counter[4];
+	uint32_t key[2];
+	uint32_t expected[4];
+} philox_case_t;
+
+static const philox_case_t PHILOX_CASES[] =
+{
+	{ { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+	{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+	{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } }
+};
+
+static void Check_philox()
+{
+	for (const philox_case_t& c : PHILOX_CASES)
+	{
+		uint32_t output[4];
+		Philox_4x32(c.counter, c.key, output);
+
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			if (output[i] != c.expected[i])
+			{
+				Report_failure("Philox_4x32 word %u is %08x instead of %08x", i, output[i], c.expected[i]);
+				break;
+			}
+		}
+	}
+}
+
+// draws of a row are the same whichever rows were drawn before
+static void Check_rows()
+{
+	const unsigned int NUM_ROWS = 64;
+	const unsigned int NUM_DRAWS = 9; // crosses blocks of four words
+
+	RandomStream forward(42, 3);
+	std::vector<double> draws(NUM_ROWS * NUM_DRAWS);
+
+	for (unsigned int row = 0; row < NUM_ROWS; row++)
+	{
+		forward.set_row(row);
+
+		for (unsigned int i = 0; i < NUM_DRAWS; i++)
+			draws[row * NUM_DRAWS + i] = Random(999.0, forward);
+	}
+
+	RandomStream backward(42, 3);
+
+	for (unsigned int row = NUM_ROWS; row-- > 0;)
+	{
+		backward.set_row(row);
+
+		for (unsigned int i = 0; i < NUM_DRAWS; i++)
+		{
+			if (Random(999.0, backward) != draws[row * NUM_DRAWS + i])
+			{
+				Report_failure("rand() of row %u depends on the order of rows", row);
+				return;
+			}
+		}
+	}
+
+	// other stream, other numbers
+	RandomStream other(42, 4);
+	unsigned int num_same = 0;
+
+	for (unsigned int i = 0; i < NUM_DRAWS; i++)
+		num_same += (Random(999.0, other) == draws[i]);
+
+	if (num_same == NUM_DRAWS)
+		Report_failure("streams 3 and 4 give the same numbers");
+}
+
+// every value in [0, range) and nothing else, about equally often
+static void Check_range()
+{
+	const uint32_t RANGE = 7;
+	const unsigned int NUM_DRAWS = 70000;
+
+	RandomStream rng(1, 0);
+	unsigned int counts[RANGE] = {};
+
+	for (unsigned int i = 0; i < NUM_DRAWS; i++)
+	{
+		uint32_t value = rng.next_below(RANGE);
+
+		if (value >= RANGE)
+		{
+			Report_failure("next_below(%u) returned %u", RANGE, value);
+			return;
+		}
+
+		counts[value]++;
+	}
+
+	for (uint32_t value = 0; value < RANGE; value++)
+		if (counts[value] < 9000 || counts[value] > 11000)
+			Report_failure("next_below(%u) returned %u %u times of %u", RANGE, value, counts[value], NUM_DRAWS);
+
+	try
+	{
+		Random(1000.0, rng);
+		Report_failure("rand(1000) was accepted");
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+unsigned int Run_random_checks()
+{
+	Check_philox();
+	Check_rows();
+	Check_range();
+
+	return 3;
+}
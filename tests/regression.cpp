@@ -0,0 +1,308 @@
+// Regression checks - scripts whose last line has a known scalar result, or
+// must be rejected with an error instead of crashing. The last line runs both
+// one-shot (Evaluate) and compiled (Compile, native when the JIT is on).
+// MS_EXPR expressions are parsed while compiling this file and must give
+// the results of Parser. Checks of other parts are in the other files of
+// tests/, all of them are linked into one program.
+//
+// Build and run (from the repository root):
+//   tests/create_tests.sh && tests/regression
+
+#include "parser.h"
+#include "static_expression.h"
+#include "script.h"
+#include "checks.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+typedef struct check {
+	std::vector<std::string> lines; // every line but the last one is run first
+	bool is_error;
+	double expected;
+} check_t;
+
+static const check_t CHECKS[] =
+{
+	// unary minus on anything but a number
+	{ { "-pi" }, false, -3.14159265358979323846 },
+	{ { "-e" }, false, -2.71828182845904523536 },
+	{ { "a = 5", "-a" }, false, -5.0 },
+	{ { "a = 5", "b = -a", "b" }, false, -5.0 },
+	{ { "a = 5", "2 * -a" }, false, -10.0 },
+	{ { "-(3)" }, false, -3.0 },
+	{ { "a = 5", "-a^2" }, false, 25.0 },
+	{ { "a = 5", "--a" }, false, 5.0 },
+	{ { "a = 5", "2 - -a" }, false, 7.0 },
+	{ { "-sqrt(4)" }, false, -2.0 },
+
+	// division of vectors and matrices by a scalar zero known only at run time
+	{ { "v = vec3(1, 2, 3)", "z = 0", "v / z" }, true, 0.0 },
+	{ { "z = 0", "mat4() / z" }, true, 0.0 },
+	{ { "z = 0", "1 / z" }, true, 0.0 },
+
+	// modulo of integers only, the error must not fall through to '^'
+	{ { "7 % 3" }, false, 1.0 },
+	{ { "x = 2.5", "7 % x" }, true, 0.0 },
+
+	// shapes checked while compiling, by the rules Do_oper and Do_func evaluate
+	{ { "length(mat2() * vec2(3, 4))" }, false, 5.0 },
+	{ { "dot(vec3(1, 2, 3), vec3(4, 5, 6)) + length(cross(vec3(1, 0, 0), vec3(0, 1, 0)))" }, false, 33.0 },
+	{ { "vec2(1, 2) + vec3(1, 2, 3)" }, true, 0.0 },
+	{ { "vec2(1, 2) + mat2()" }, true, 0.0 },
+	{ { "vec2(1, 2) * vec2(3, 4)" }, true, 0.0 },
+	{ { "length(cross(vec2(1, 2), vec3(1, 2, 3)))" }, true, 0.0 },
+	{ { "length(rotate(mat3(), 1, vec3(1, 0, 0)))" }, true, 0.0 },
+
+	// operators and functions without an operand
+	{ { "()" }, true, 0.0 },
+	{ { "(1 +)" }, true, 0.0 },
+	{ { "(-)" }, true, 0.0 },
+	{ { "2 * )" }, true, 0.0 },
+	{ { "sin()" }, true, 0.0 },
+	{ { "vec3(1,)" }, true, 0.0 },
+};
+
+int num_failed = 0;
+
+static void Fail(const check_t& check, const char* what)
+{
+	Report_failure("\"%s\" %s", check.lines.back().c_str(), what);
+}
+
+static void Compare(const check_t& check, const Math_solver::value_t& value, const char* path)
+{
+	char text[128];
+	double result = value.vec.to_scalar();
+
+	if (check.is_error)
+		snprintf(text, sizeof(text), "(%s) returned %g instead of an error", path, result);
+	else if (std::fabs(result - check.expected) > 1e-12 * std::fmax(1.0, std::fabs(check.expected)))
+		snprintf(text, sizeof(text), "(%s) returned %.17g instead of %.17g", path, result, check.expected);
+	else
+		return;
+
+	Fail(check, text);
+}
+
+static void Run_check(const check_t& check)
+{
+	Math_solver::Context context(1);
+
+	try
+	{
+		for (size_t i = 0; i + 1 < check.lines.size(); i++)
+			Math_solver::Parser(check.lines[i], context).Evaluate();
+	}
+	catch (const std::exception& e)
+	{
+		Fail(check, e.what());
+		return;
+	}
+
+	const std::string& last = check.lines.back();
+
+	try
+	{
+		Compare(check, Math_solver::Parser(last, context).Evaluate(), "Evaluate");
+	}
+	catch (const std::exception& e)
+	{
+		if (!check.is_error)
+			Fail(check, e.what());
+	}
+
+	try
+	{
+		Math_solver::Parser parser(last, context);
+		Compare(check, parser.Compile().evaluate(), "Compile");
+	}
+	catch (const std::exception& e)
+	{
+		if (!check.is_error)
+			Fail(check, e.what());
+	}
+}
+
+// bad lines of a pipe are reported in place of their results, the rest still runs
+static void Check_pipe()
+{
+	static const char INPUT[] = "-(3)\n()\nx = 2\n-x\n(1 +)\n2 * -x\n";
+	static const char EXPECTED[] = "-3\n-2\n-4\n";
+
+	FILE* input = tmpfile();
+	FILE* output = tmpfile();
+
+	if (input == nullptr || output == nullptr)
+	{
+		Report_failure("Run_pipe, no temporary files");
+		return;
+	}
+
+	fputs(INPUT, input);
+	rewind(input);
+
+	Math_solver::Context context(1);
+	bool is_ok = Math_solver::Run_pipe(input, output, context);
+
+	// keeps only results, errors are on lines of their own
+	char line[512];
+	std::string results;
+
+	rewind(output);
+
+	while (fgets(line, sizeof(line), output) != nullptr)
+		if (strstr(line, "Error") == nullptr)
+			results += line;
+
+	if (is_ok || results != EXPECTED)
+	{
+		Report_failure("Run_pipe returned %s and \"%s\"", is_ok ? "true" : "false", results.c_str());
+	}
+
+	fclose(input);
+	fclose(output);
+}
+
+// long bad tokens are quoted cut short, the pipe goes on after them
+static void Check_long_error()
+{
+	std::string text = "1 " + std::string(400, 'a') + "\n1 + 2" + std::string(400, ')') + "\n3 1" + std::string(400, '2') + "x\n2 * 3\n";
+
+	FILE* input = tmpfile();
+	FILE* output = tmpfile();
+
+	if (input == nullptr || output == nullptr)
+	{
+		Report_failure("Run_pipe, no temporary files");
+		return;
+	}
+
+	fputs(text.c_str(), input);
+	rewind(input);
+
+	Math_solver::Context context(1);
+	Math_solver::Run_pipe(input, output, context);
+
+	char line[1024];
+	unsigned int num_errors = 0;
+	bool has_result = false;
+
+	rewind(output);
+
+	while (fgets(line, sizeof(line), output) != nullptr)
+	{
+		if (strstr(line, "Error") != nullptr && strstr(line, "...") != nullptr && strlen(line) < 300)
+			num_errors++;
+		else if (strcmp(line, "6\n") == 0)
+			has_result = true;
+	}
+
+	if (num_errors != 3 || !has_result)
+	{
+		Report_failure("long bad lines gave %u cut errors%s", num_errors, has_result ? "" : " and no result of the next line");
+	}
+
+	fclose(input);
+	fclose(output);
+}
+
+// every variable read is resolved to its slot once, while parsing
+static void Check_metrics()
+{
+	Math_solver::Context context(1);
+
+	Math_solver::Parser("a = 1", context).Evaluate();
+	Math_solver::Parser("a + a * pi", context).Evaluate();
+
+	uint64_t num_names = context.get_metrics().get_num_names_resolved();
+
+	if (num_names != 2)
+	{
+		Report_failure("%llu names resolved instead of 2", (unsigned long long)num_names);
+	}
+}
+
+// nodes made by folding and by unary minus are counted like parsed ones
+static void Check_node_metrics()
+{
+	Math_solver::Context context(1);
+	Math_solver::Parser("x * -(2 + 3)", context).Compile({ "x" });
+
+	// 2, 3 and the sign -1 parsed, 5 and -5 folded
+	uint64_t num_numbers = context.get_metrics().get_num_nodes(Math_solver::SCALAR);
+	uint64_t num_products = context.get_metrics().get_num_nodes(Math_solver::MULTIPLY);
+
+	if (num_numbers != 5 || num_products != 2)
+	{
+		Report_failure("%llu numbers and %llu products counted instead of 5 and 2", (unsigned long long)num_numbers, (unsigned long long)num_products);
+	}
+}
+
+// "x" is 3 and "y" is 5
+static void Check_static(const char* text, double result)
+{
+	Math_solver::Context context(1);
+	context.get_variables().set("x", Math_solver::value_t(3.0));
+	context.get_variables().set("y", Math_solver::value_t(5.0));
+
+	double expected = Math_solver::Parser(text, context).Evaluate().vec.to_scalar();
+
+	if (result != expected)
+	{
+		Report_failure("MS_EXPR(\"%s\") returned %.17g instead of %.17g", text, result, expected);
+	}
+}
+
+#define CHECK_STATIC(text, ...) Check_static(text, MS_EXPR(text)(__VA_ARGS__))
+
+static unsigned int Run_static_checks()
+{
+	auto expression = MS_EXPR("y * x + y");
+
+	static_assert(decltype(expression)::NUM_VARIABLES == 2, "variables are counted once");
+	static_assert(decltype(expression)::get_variable(0) == "y", "variables are numbered by first appearance");
+	Check_static("y * x + y", expression(5.0, 3.0));
+
+	CHECK_STATIC("2 * pi + e");
+	CHECK_STATIC("3! + 7 % 4 - 2 ^ 3 ^ 2");
+	CHECK_STATIC("0x1F + 0b101 - 0o17 + 1.5");
+	CHECK_STATIC("3.14159265358979323846264 * 2"); // not exact while compiling
+	CHECK_STATIC("0.1 + 0.2");
+	CHECK_STATIC("sqrt(x ^ 2 + y ^ 2) / ln(e)", 3.0, 5.0);
+	CHECK_STATIC("-x ^ 2 + -(y - 1) * --x", 3.0, 5.0);
+	CHECK_STATIC("-pi - -sin(x) + x * -2", 3.0);
+
+	return 9;
+}
+
+int main()
+{
+	size_t num_checks = sizeof(CHECKS) / sizeof(CHECKS[0]);
+
+	for (size_t i = 0; i < num_checks; i++)
+		Run_check(CHECKS[i]);
+
+	num_checks += Run_static_checks();
+
+	Check_pipe();
+	Check_long_error();
+	Check_metrics();
+	Check_node_metrics();
+	num_checks += 4;
+
+	num_checks += Run_batch_checks();
+	num_checks += Run_simd_checks();
+	num_checks += Run_random_checks();
+	num_checks += Run_jit_checks();
+	num_checks += Run_format_checks();
+	num_checks += Run_output_checks();
+
+	printf("%zu checks, %d failed\n", num_checks, num_failed);
+	return (num_failed == 0) ? 0 : 1;
+}
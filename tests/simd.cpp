@@ -0,0 +1,120 @@
+// Element-wise kernels - every instruction set the CPU supports, and the
+// inlined single blocks, must give the scalar fallback's results bit for bit,
+// for every operation, number of blocks and number of lanes.
+
+#include "simd.h"
+#include "checks.h"
+
+#include <cstring>
+
+
+using namespace Math_solver;
+
+static const char* SET_NAMES[NUM_INSTRUCTION_SETS] = { "scalar", "sse2", "avx" };
+
+// 16 doubles of both operands, one more so the kernels see unaligned blocks too
+static double left_data[17];
+static double right_data[17];
+
+static void Fill_operands()
+{
+	for (unsigned int i = 0; i < 17; i++)
+	{
+		left_data[i] = (i % 2 ? -1.0 : 1.0) * (i + 1) * 0.37;
+		right_data[i] = 3.0 - i * 0.71; // never zero
+	}
+}
+
+static bool Is_same(const double* result, const double* expected)
+{
+	return memcmp(result, expected, 16 * sizeof(double)) == 0;
+}
+
+static void Check_set(InstructionSet set, unsigned int offset)
+{
+	const double* a = left_data + offset;
+	const double* b = right_data + offset;
+
+	for (unsigned int op = 0; op < NUM_ELEMENT_OPS; op++)
+	{
+		for (unsigned int num_blocks = 1; num_blocks <= 4; num_blocks++)
+		{
+			for (unsigned int num_lanes = 0; num_lanes <= 4; num_lanes++)
+			{
+				double result[16], expected[16];
+
+				// blocks past "num_blocks" must stay as they are
+				memset(result, 0x55, sizeof(result));
+				memset(expected, 0x55, sizeof(expected));
+
+				Simd_vector_vector_kernel(ElementOp(op), set)(a, b, result, num_blocks, num_lanes);
+				Simd_vector_vector_kernel(ElementOp(op), SIMD_SCALAR)(a, b, expected, num_blocks, num_lanes);
+
+				if (!Is_same(result, expected))
+					Report_failure("%s vector_vector op %u, %u blocks, %u lanes differs from scalar", SET_NAMES[set], op, num_blocks, num_lanes);
+
+				memset(result, 0x55, sizeof(result));
+				memset(expected, 0x55, sizeof(expected));
+
+				Simd_vector_scalar_kernel(ElementOp(op), set)(a, b[3], result, num_blocks, num_lanes);
+				Simd_vector_scalar_kernel(ElementOp(op), SIMD_SCALAR)(a, b[3], expected, num_blocks, num_lanes);
+
+				if (!Is_same(result, expected))
+					Report_failure("%s vector_scalar op %u, %u blocks, %u lanes differs from scalar", SET_NAMES[set], op, num_blocks, num_lanes);
+			}
+		}
+	}
+}
+
+template<ElementOp OP>
+static void Check_block()
+{
+	for (unsigned int num_lanes = 0; num_lanes <= 4; num_lanes++)
+	{
+		double result[16], expected[16];
+
+		memset(result, 0x55, sizeof(result));
+		memset(expected, 0x55, sizeof(expected));
+
+		Simd_block_vector_vector<OP>(left_data, right_data, result, num_lanes);
+		Simd_vector_vector_kernel(OP, SIMD_SCALAR)(left_data, right_data, expected, 1, num_lanes);
+
+		if (!Is_same(result, expected))
+			Report_failure("inline vector_vector op %u, %u lanes differs from scalar", (unsigned int)OP, num_lanes);
+
+		memset(result, 0x55, sizeof(result));
+		memset(expected, 0x55, sizeof(expected));
+
+		Simd_block_vector_scalar<OP>(left_data, right_data[5], result, num_lanes);
+		Simd_vector_scalar_kernel(OP, SIMD_SCALAR)(left_data, right_data[5], expected, 1, num_lanes);
+
+		if (!Is_same(result, expected))
+			Report_failure("inline vector_scalar op %u, %u lanes differs from scalar", (unsigned int)OP, num_lanes);
+	}
+}
+
+unsigned int Run_simd_checks()
+{
+	unsigned int num_checks = 0;
+
+	Fill_operands();
+
+	for (unsigned int set = SIMD_SSE2; set < NUM_INSTRUCTION_SETS; set++)
+	{
+		if (!Simd_is_supported(InstructionSet(set)))
+			continue;
+
+		Check_set(InstructionSet(set), 0);
+		Check_set(InstructionSet(set), 1);
+		num_checks += 2;
+	}
+
+	Check_block<ELEMENT_ADD>();
+	Check_block<ELEMENT_SUBTRACT>();
+	Check_block<ELEMENT_MULTIPLY>();
+	Check_block<ELEMENT_DIVIDE>();
+	Check_block<ELEMENT_SUBTRACT_REVERSED>();
+	Check_block<ELEMENT_DIVIDE_REVERSED>();
+
+	return num_checks + NUM_ELEMENT_OPS;
+}
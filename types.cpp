@@ -1,248 +1,266 @@
-#include "types.h"
-#include "operations.h"
-#include "config.h"
-#include "error.h"
-
-#include <sstream>
-#include <iostream>
-//#include <iomanip>
-
-
-namespace Math_solver {
-
-	std::string value_vec_t::to_str(unsigned int max_precision) const
-	{
-		std::ostringstream result;
-
-		if (_num_dims == 1)
-		{
-			if (FORMAT_RESULT)
-				result << Format_number(_value[0], max_precision);
-			else
-				result << std::to_string(RoundOff(_value[0], max_precision));
-
-			return result.str();
-		}
-
-		result << std::string("( ");
-
-		for (unsigned int i = 0; i < _num_dims; i++)
-		{
-			if (FORMAT_RESULT)
-				result << Format_number(_value[i], max_precision);
-			else
-				result << std::to_string(RoundOff(_value[i], max_precision));
-
-			if (i < (_num_dims - 1))
-				result << std::string(", ");
-		}
-
-		result << std::string(" )");
-
-		return result.str();
-	}
-
-	std::string value_mat_t::to_str(unsigned int max_precision) const
-	{
-		std::ostringstream result;
-
-		result << std::endl;
-
-		for (unsigned int i = 0; i < _num_dims; i++)
-		{
-			result << std::string("( ");
-
-			for (unsigned int j = 0; j < _num_dims; j++)
-			{
-				if (FORMAT_RESULT)
-					result << Format_number(_value[i][j], max_precision);
-				else
-					result << std::to_string(RoundOff(_value[i][j], max_precision));
-
-				if (j < (_num_dims - 1))
-					result << std::string(", ");
-			}
-
-			result << std::string(" )");
-			result << std::endl;
-		}
-
-		return result.str();
-	}
-
-	value_t operator *(const value_t& left, const value_t& right)
-	{
-		value_t result;
-
-		if (!left.is_mat())
-			Throw_error(__FILE__, __LINE__, __func__, "Bad operand order");
-
-		if (right.is_mat())
-		{
-			if (left.mat.get_num_dims() != right.mat.get_num_dims())
-				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
-
-			switch (right.mat.get_num_dims())
-			{
-			case 2:
-				result.mat.set_mat2(left.mat.to_mat2() * right.mat.to_mat2());
-				break;
-			case 3:
-				result.mat.set_mat3(left.mat.to_mat3() * right.mat.to_mat3());
-				break;
-			case 4:
-				result.mat.set_mat4(left.mat.to_mat4() * right.mat.to_mat4());
-				break;
-			default:
-				Throw_error(__FILE__, __LINE__, __func__, "Wrong number of dimensions");
-			}
-		}
-		else // right is vector
-		{
-			if (left.mat.get_num_dims() != right.vec.get_num_dims())
-				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
-
-			switch (right.vec.get_num_dims())
-			{
-			case 2:
-				result.vec.set_vec2(left.mat.to_mat2() * right.vec.to_vec2());
-				break;
-			case 3:
-				result.vec.set_vec3(left.mat.to_mat3() * right.vec.to_vec3());
-				break;
-			case 4:
-				result.vec.set_vec4(left.mat.to_mat4() * right.vec.to_vec4());
-				break;
-			default:
-				Throw_error(__FILE__, __LINE__, __func__, "Wrong number of dimensions");
-			}
-		}
-
-		return result;
-	}
-
-	value_t OperNode::value()
-	{
-		value_t leftValue = left->value();
-		value_t rightValue = right->value();
-		value_t result;
-
-		unsigned int lnumdims = left->value().vec.get_num_dims();
-		unsigned int rnumdims = right->value().vec.get_num_dims();
-
-		if (!leftValue.is_mat() && !rightValue.is_mat()) // not matrices
-		{
-			if ((lnumdims == 1) && (rnumdims == 1)) // two scalars
-			{
-				switch (oper)
-				{
-				case '+': return value_t(glm::dvec4(leftValue.vec.to_vec4()[0] + rightValue.vec.to_vec4()[0]));
-				case '-': return value_t(glm::dvec4(leftValue.vec.to_vec4()[0] - rightValue.vec.to_vec4()[0]));
-				case '*': return value_t(glm::dvec4(leftValue.vec.to_vec4()[0] * rightValue.vec.to_vec4()[0]));
-				case '/': return value_t(glm::dvec4(leftValue.vec.to_vec4()[0] / rightValue.vec.to_vec4()[0]));
-				case '%': 
-					if (ceil(leftValue.vec.to_vec4()[0]) == leftValue.vec.to_vec4()[0] && 
-						ceil(rightValue.vec.to_vec4()[0]) == rightValue.vec.to_vec4()[0]) // check if integer
-						return value_t(glm::dvec4((long)leftValue.vec.to_vec4()[0] % (long)rightValue.vec.to_vec4()[0]));
-					else
-						Throw_error(__FILE__, __LINE__, __func__, "Both operand must be integer");
-				case '^': return value_t(glm::dvec4(pow(leftValue.vec.to_vec4()[0], rightValue.vec.to_vec4()[0])));
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar operator: %c", oper);
-				}
-			}
-			else if ((lnumdims == 1 && rnumdims != 1)) // one scalar, one vector
-			{
-				switch (oper)
-				{
-				case '+': return Do_vector_scalar(rightValue, leftValue, [](auto a, auto b) {return a + b; });
-				case '-': return Do_vector_scalar(rightValue, leftValue, [](auto a, auto b) {return b - a; });
-				case '*': return Do_vector_scalar(rightValue, leftValue, [](auto a, auto b) {return a * b; });
-				case '/': return Do_vector_scalar(rightValue, leftValue, [](auto a, auto b) {return b / a; });
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar-vector operator: %c", oper);
-				}
-			}
-			else if ((lnumdims != 1 && rnumdims == 1)) // one vector, one scalar
-			{
-				switch (oper)
-				{
-				case '+': return Do_vector_scalar(leftValue, rightValue, [](auto a, auto b) {return a + b; });
-				case '-': return Do_vector_scalar(leftValue, rightValue, [](auto a, auto b) {return a - b; });
-				case '*': return Do_vector_scalar(leftValue, rightValue, [](auto a, auto b) {return a * b; });
-				case '/': return Do_vector_scalar(leftValue, rightValue, [](auto a, auto b) {return a / b; });
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown vector-scalar operator: %c", oper);
-				}
-			}
-			else if (lnumdims == rnumdims) // two (same-dimensional) vectors
-			{
-				switch (oper)
-				{
-				case '+': return Do_vector_vector(leftValue, rightValue, [](auto a, auto b) {return a + b; });
-				case '-': return Do_vector_vector(leftValue, rightValue, [](auto a, auto b) {return a - b; });
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown vector-vector operator: %c", oper);
-				}
-			}
-		}
-
-		if (leftValue.is_mat() && rightValue.is_mat()) // matrix-matrix
-		{
-			if (lnumdims == rnumdims) {
-				switch (oper)
-				{
-				case '*': return (leftValue * rightValue);
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-matrix operator: %c", oper);
-				}
-			}
-			else
-				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
-		}
-
-		if (leftValue.is_mat() && !rightValue.is_mat()) 
-		{
-			if (lnumdims == rnumdims) { // matrix-vector
-				switch (oper)
-				{
-				case '*': return (leftValue * rightValue);
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-vector operator: %c", oper);
-				}
-			}
-			else if (rnumdims == 1) { // matrix-scalar
-				switch (oper)
-				{
-				case '+': return Do_matrix_scalar(leftValue, rightValue, [](auto a, auto b) {return a + b; });
-				case '-': return Do_matrix_scalar(leftValue, rightValue, [](auto a, auto b) {return a - b; });
-				case '*': return Do_matrix_scalar(leftValue, rightValue, [](auto a, auto b) {return a * b; });
-				case '/': return Do_matrix_scalar(leftValue, rightValue, [](auto a, auto b) {return a / b; });
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown matrix-scalar operator: %c", oper);
-				}
-			}
-			else
-				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
-		}
-
-		if (!leftValue.is_mat() && rightValue.is_mat())
-		{
-			if (lnumdims == 1) { // scalar-matrix
-				switch (oper)
-				{
-				case '+': return Do_matrix_scalar(rightValue, leftValue, [](auto a, auto b) {return a + b; });
-				case '-': return Do_matrix_scalar(rightValue, leftValue, [](auto a, auto b) {return b - a; });
-				case '*': return Do_matrix_scalar(rightValue, leftValue, [](auto a, auto b) {return a * b; });
-				case '/': return Do_matrix_scalar(rightValue, leftValue, [](auto a, auto b) {return b / a; });
-				default: Throw_error(__FILE__, __LINE__, __func__, "Unknown scalar-matrix operator: %c", oper);
-				}
-			}
-			else
-				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
-		}
-
-		Throw_error(__FILE__, __LINE__, __func__, "Wrong operation");
-
-		return result;
-	}
-
-	value_t FuncNode::value()
-	{
-		return Do_func(_func, _expression1, _expression2, _expression3, _expression4);
-	}
-
+#include "types.h"
+#include "operations.h"
+#include "program.h"
+#include "arena.h"
+#include "config.h"
+#include "error.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+//#include <iomanip>
+
+
+namespace Math_solver {
+
+	// number as shown in results
+	static size_t Write_element(char* buffer, double value, unsigned int max_precision)
+	{
+		if (FORMAT_RESULT)
+			return Format_number(value, max_precision, buffer);
+		else
+			return snprintf(buffer, NUMBER_STR_SIZE, "%f", RoundOff(value, max_precision)); // as std::to_string
+	}
+
+	static size_t Write_text(char* buffer, const char* text)
+	{
+		size_t length = strlen(text);
+		memcpy(buffer, text, length);
+
+		return length;
+	}
+
+	size_t value_vec_t::to_chars(char* buffer, unsigned int max_precision) const
+	{
+		if (_num_dims == 1)
+			return Write_element(buffer, _value[0], max_precision);
+
+		char* p = buffer;
+
+		p += Write_text(p, "( ");
+
+		for (unsigned int i = 0; i < _num_dims; i++)
+		{
+			p += Write_element(p, _value[i], max_precision);
+
+			if (i < (_num_dims - 1))
+				p += Write_text(p, ", ");
+		}
+
+		p += Write_text(p, " )");
+
+		return p - buffer;
+	}
+
+	std::string value_vec_t::to_str(unsigned int max_precision) const
+	{
+		char buffer[VALUE_STR_SIZE];
+
+		return std::string(buffer, to_chars(buffer, max_precision));
+	}
+
+	size_t value_mat_t::to_chars(char* buffer, unsigned int max_precision) const
+	{
+		char* p = buffer;
+
+		*p++ = '\n';
+
+		for (unsigned int i = 0; i < _num_dims; i++)
+		{
+			p += Write_text(p, "( ");
+
+			for (unsigned int j = 0; j < _num_dims; j++)
+			{
+				p += Write_element(p, _value[i][j], max_precision);
+
+				if (j < (_num_dims - 1))
+					p += Write_text(p, ", ");
+			}
+
+			p += Write_text(p, " )\n");
+		}
+
+		return p - buffer;
+	}
+
+	std::string value_mat_t::to_str(unsigned int max_precision) const
+	{
+		char buffer[VALUE_STR_SIZE];
+
+		return std::string(buffer, to_chars(buffer, max_precision));
+	}
+
+	value_t operator *(const value_t& left, const value_t& right)
+	{
+		value_t result;
+
+		if (!left.is_mat())
+			Throw_error(__FILE__, __LINE__, __func__, "Bad operand order");
+
+		if (right.is_mat())
+		{
+			if (left.mat.get_num_dims() != right.mat.get_num_dims())
+				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
+
+			switch (right.mat.get_num_dims())
+			{
+			case 2:
+				result.mat.set_mat2(left.mat.to_mat2() * right.mat.to_mat2());
+				break;
+			case 3:
+				result.mat.set_mat3(left.mat.to_mat3() * right.mat.to_mat3());
+				break;
+			case 4:
+				result.mat.set_mat4(left.mat.to_mat4() * right.mat.to_mat4());
+				break;
+			default:
+				Throw_error(__FILE__, __LINE__, __func__, "Wrong number of dimensions");
+			}
+		}
+		else // right is vector
+		{
+			if (left.mat.get_num_dims() != right.vec.get_num_dims())
+				Throw_error(__FILE__, __LINE__, __func__, "Different bases");
+
+			switch (right.vec.get_num_dims())
+			{
+			case 2:
+				result.vec.set_vec2(left.mat.to_mat2() * right.vec.to_vec2());
+				break;
+			case 3:
+				result.vec.set_vec3(left.mat.to_mat3() * right.vec.to_vec3());
+				break;
+			case 4:
+				result.vec.set_vec4(left.mat.to_mat4() * right.vec.to_vec4());
+				break;
+			default:
+				Throw_error(__FILE__, __LINE__, __func__, "Wrong number of dimensions");
+			}
+		}
+
+		return result;
+	}
+
+	value_t ParamNode::value(const Bindings& bindings)
+	{
+		if (_index >= bindings.size())
+			Throw_error(__FILE__, __LINE__, __func__, "Unbound parameter: %u", _index);
+
+		return bindings[_index];
+	}
+
+	value_t OperNode::value(const Bindings& bindings)
+	{
+		value_t leftValue = left->value(bindings);
+		value_t rightValue = right->value(bindings);
+
+		return Do_oper(oper, leftValue, rightValue);
+	}
+
+	value_t FuncNode::value(const Bindings& bindings)
+	{
+		// each parameter is evaluated exactly once, missing ones stay scalar zero
+		value_t first, second, third, fourth;
+
+		if (_expression1 != nullptr)
+			first = _expression1->value(bindings);
+		if (_expression2 != nullptr)
+			second = _expression2->value(bindings);
+		if (_expression3 != nullptr)
+			third = _expression3->value(bindings);
+		if (_expression4 != nullptr)
+			fourth = _expression4->value(bindings);
+
+		return Do_func(_func, first, second, third, fourth, nullptr); // folding only, rand() is never constant
+	}
+
+	BaseNode* AssignNode::fold(NodeArena& arena)
+	{
+		_expression = _expression->fold(arena);
+
+		return this;
+	}
+
+	BaseNode* OperNode::fold(NodeArena& arena)
+	{
+		left = left->fold(arena);
+		right = right->fold(arena);
+
+		if (oper == '/' && right->is_constant()) {
+			value_t divisor = right->value();
+
+			if (!divisor.is_mat() && divisor.vec.to_vec4()[0] == 0.0)
+				Throw_error(__FILE__, __LINE__, __func__, "Division by zero!");
+		}
+
+		if (is_constant())
+			return arena.create<NumNode>(BaseNode::value());
+
+		return this;
+	}
+
+	BaseNode* FuncNode::fold(NodeArena& arena)
+	{
+		if (_expression1 != nullptr)
+			_expression1 = _expression1->fold(arena);
+		if (_expression2 != nullptr)
+			_expression2 = _expression2->fold(arena);
+		if (_expression3 != nullptr)
+			_expression3 = _expression3->fold(arena);
+		if (_expression4 != nullptr)
+			_expression4 = _expression4->fold(arena);
+
+		if (is_constant())
+			return arena.create<NumNode>(BaseNode::value());
+
+		return this;
+	}
+
+	unsigned int NumNode::emit(Program& program) const
+	{
+		return program.add_constant(_value);
+	}
+
+	unsigned int ParamNode::emit(Program& program) const
+	{
+		return program.add_parameter(_index);
+	}
+
+	unsigned int VarNode::emit(Program& program) const
+	{
+		return program.add_load(_slots, _index);
+	}
+
+	unsigned int AssignNode::emit(Program& program) const
+	{
+		unsigned int expression = _expression->emit(program);
+
+		return program.add_store(_slots, _index, expression);
+	}
+
+	unsigned int OperNode::emit(Program& program) const
+	{
+		unsigned int leftValue = left->emit(program);
+		unsigned int rightValue = right->emit(program);
+
+		return program.add_operator(oper, leftValue, rightValue);
+	}
+
+	unsigned int FuncNode::emit(Program& program) const
+	{
+		unsigned int parameters[4];
+		unsigned int num_parameters = 0;
+
+		if (_expression1 != nullptr)
+			parameters[num_parameters++] = _expression1->emit(program);
+		if (_expression2 != nullptr)
+			parameters[num_parameters++] = _expression2->emit(program);
+		if (_expression3 != nullptr)
+			parameters[num_parameters++] = _expression3->emit(program);
+		if (_expression4 != nullptr)
+			parameters[num_parameters++] = _expression4->emit(program);
+
+		return program.add_function(_func, parameters, num_parameters);
+	}
+
 }
\ No newline at end of file
@@ -1,251 +1,518 @@
-#ifndef TYPES_H
-#define TYPES_H
-
-#include <math.h>
-
-#define GLM_FORCE_RADIANS
-#include <glm/glm.hpp>
-#include <glm/ext.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-#include <new>
-
-#include "functions.h"
-
-
-namespace Math_solver {
-
-	typedef struct value_vec {
-
-		value_vec() {
-			_value = glm::dvec4(0.0);
-			_num_dims = 1;
-			_is_vec = true;
-		}
-
-		value_vec(glm::dvec4 v, unsigned int d = 1) {
-			_value = v;
-			_num_dims = d;
-			_is_vec = true;
-		}
-
-		unsigned int get_num_dims() const {
-			return _num_dims;
-		}
-
-		bool is_mat() const {
-			return !_is_vec;
-		}
-
-		double to_scalar() const {
-			return _value[0];
-		}
-
-		glm::dvec2 to_vec2() const {
-			return glm::dvec2(_value[0], _value[1]);
-		}
-
-		glm::dvec3 to_vec3() const {
-			return glm::dvec3(_value[0], _value[1], _value[2]);
-		}
-
-		glm::dvec4 to_vec4() const {
-			return glm::dvec4(_value[0], _value[1], _value[2], _value[3]);
-		}
-
-		void set_scalar(double v) {
-			_num_dims = 1;
-			_value[0] = v;
-			_is_vec = true;
-		}
-
-		void set_vec2(glm::dvec2 v) {
-			_num_dims = 2;
-			_value[0] = v.x;
-			_value[1] = v.y;
-			_is_vec = true;
-		}
-
-		void set_vec3(glm::dvec3 v) {
-			_num_dims = 3;
-			_value[0] = v.x;
-			_value[1] = v.y;
-			_value[2] = v.z;
-			_is_vec = true;
-		}
-
-		void set_vec4(glm::dvec4 v) {
-			_num_dims = 4;
-			_value[0] = v.x;
-			_value[1] = v.y;
-			_value[2] = v.z;
-			_value[3] = v.w;
-			_is_vec = true;
-		}
-
-		std::string to_str(unsigned int max_precision = 3) const;
-
-	private:
-		bool _is_vec; // common
-		unsigned int _num_dims;
-		glm::dvec4 _value;
-
-	} value_vec_t;
-
-	typedef struct value_mat {
-
-		value_mat() {
-			_value = glm::dmat4(1.0);
-			_num_dims = 2;
-			_is_vec = false;
-		}
-
-		value_mat(glm::dmat4 m, unsigned int d = 2) {
-			_value = m;
-			_num_dims = d;
-			_is_vec = false;
-		}
-
-		unsigned int get_num_dims() const {
-			return _num_dims;
-		}
-
-		bool is_mat() const {
-			return !_is_vec;
-		}
-
-		glm::dmat2 to_mat2() const {
-			return glm::dmat2(
-				_value[0][0], _value[0][1],
-				_value[1][0], _value[1][1]);
-		}
-
-		glm::dmat3 to_mat3() const {
-			return glm::dmat3(
-				_value[0][0], _value[0][1], _value[0][2],
-				_value[1][0], _value[1][1], _value[1][2],
-				_value[2][0], _value[2][1], _value[2][2]);
-		}
-
-		glm::dmat4 to_mat4() const {
-			return glm::dmat4(
-				_value[0][0], _value[0][1], _value[0][2], _value[0][3],
-				_value[1][0], _value[1][1], _value[1][2], _value[1][3],
-				_value[2][0], _value[2][1], _value[2][2], _value[2][3],
-				_value[3][0], _value[3][1], _value[3][2], _value[3][3]);
-		}
-
-		void set_mat2(glm::dmat2 m) {
-			_num_dims = 2;
-			_value[0][0] = m[0][0]; _value[0][1] = m[0][1];
-			_value[1][0] = m[1][0]; _value[1][1] = m[0][0];
-			_is_vec = false;
-		}
-
-		void set_mat3(glm::dmat3 m) {
-			_num_dims = 3;
-			_value[0][0] = m[0][0]; _value[0][1] = m[0][1]; _value[0][2] = m[0][2];
-			_value[1][0] = m[1][0]; _value[1][1] = m[1][1]; _value[1][2] = m[1][2];
-			_value[2][0] = m[2][0]; _value[2][1] = m[2][1]; _value[2][2] = m[2][2];
-			_is_vec = false;
-		}
-
-		void set_mat4(glm::dmat4 m) {
-			_num_dims = 4;
-			_value[0][0] = m[0][0]; _value[0][1] = m[0][1]; _value[0][2] = m[0][2]; _value[0][3] = m[0][3];
-			_value[1][0] = m[1][0]; _value[1][1] = m[1][1]; _value[1][2] = m[1][2]; _value[1][3] = m[1][3];
-			_value[2][0] = m[2][0]; _value[2][1] = m[2][1]; _value[2][2] = m[2][2]; _value[2][3] = m[2][3];
-			_value[3][0] = m[3][0]; _value[3][1] = m[3][1]; _value[3][2] = m[3][2]; _value[3][3] = m[3][3];
-			_is_vec = false;
-		}
-
-		std::string to_str(unsigned int max_precision = 3) const;
-
-	private:
-		bool _is_vec; // common 
-		unsigned int _num_dims;
-		glm::dmat4 _value;
-
-	} value_mat_t;
-
-	typedef struct value {
-
-		value() {
-			new(&vec) value_vec_t();
-		}
-
-		value(glm::dvec4 v, unsigned int d = 1) {
-			new(&vec) value_vec_t(v, d);
-		}
-
-		value(glm::dmat4 m, unsigned int d = 2) {
-			new(&mat) value_mat_t(m, d);
-		}
-
-		bool is_mat() const {
-			return vec.is_mat();
-		}
-
-		union {
-			value_vec_t vec;
-			value_mat_t mat;
-		};
-	} value_t;
-
-	value_t operator *(const value_t& left, const value_t& right);
-
-	class BaseNode
-	{
-	public:
-		virtual value_t value() = 0;
-	};
-
-	class NumNode : public BaseNode
-	{
-		value_t _value;
-	public:
-		NumNode(value_t value)
-		{
-			_value = value;
-		}
-		virtual value_t value()
-		{
-			return _value;
-		}
-	};
-
-	class OperNode : public BaseNode
-	{
-		char oper;
-		BaseNode* left;
-		BaseNode* right;
-	public:
-		OperNode(char oper, BaseNode* left, BaseNode* right)
-		{
-			this->oper = oper;
-			this->right = right;
-			this->left = left;
-		}
-		virtual value_t value();
-	};
-
-	class FuncNode : public BaseNode
-	{
-		BaseNode* _expression1, * _expression2, * _expression3, * _expression4;
-		TokenType _func;
-
-	public:
-		FuncNode(TokenType func, BaseNode* expression1, BaseNode* expression2 = nullptr, BaseNode* expression3 = nullptr, BaseNode* expression4 = nullptr)
-		{
-			_func = func;
-			_expression1 = expression1;
-			_expression2 = expression2;
-			_expression3 = expression3;
-			_expression4 = expression4;
-		}
-		virtual value_t value();
-	};
-
-}
-
-#endif // !TYPES_H
\ No newline at end of file
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <math.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+#include <new>
+#include <vector>
+
+#include "functions.h"
+
+
+namespace Math_solver {
+
+	// longest formatted number: sign, 309 integer digits with separators, point and six decimals
+	const size_t NUMBER_STR_SIZE = 448;
+
+	// longest text of a value, a 4x4 matrix
+	const size_t VALUE_STR_SIZE = 16 * (NUMBER_STR_SIZE + 2) + 32;
+
+	typedef struct value_vec {
+
+		value_vec() {
+			_value = glm::dvec4(0.0);
+			_num_dims = 1;
+			_is_vec = true;
+		}
+
+		value_vec(glm::dvec4 v, unsigned int d = 1) {
+			_value = v;
+			_num_dims = d;
+			_is_vec = true;
+		}
+
+		unsigned int get_num_dims() const {
+			return _num_dims;
+		}
+
+		bool is_mat() const {
+			return !_is_vec;
+		}
+
+		double to_scalar() const {
+			return _value[0];
+		}
+
+		glm::dvec2 to_vec2() const {
+			return glm::dvec2(_value[0], _value[1]);
+		}
+
+		glm::dvec3 to_vec3() const {
+			return glm::dvec3(_value[0], _value[1], _value[2]);
+		}
+
+		const glm::dvec4& to_vec4() const {
+			return _value;
+		}
+
+		// all 4 lanes, contiguous
+		const double* data() const {
+			return &_value[0];
+		}
+
+		double* data() {
+			return &_value[0];
+		}
+
+		void set_scalar(double v) {
+			_num_dims = 1;
+			_value[0] = v;
+			_is_vec = true;
+		}
+
+		void set_vec2(glm::dvec2 v) {
+			_num_dims = 2;
+			_value[0] = v.x;
+			_value[1] = v.y;
+			_is_vec = true;
+		}
+
+		void set_vec3(glm::dvec3 v) {
+			_num_dims = 3;
+			_value[0] = v.x;
+			_value[1] = v.y;
+			_value[2] = v.z;
+			_is_vec = true;
+		}
+
+		void set_vec4(glm::dvec4 v) {
+			_num_dims = 4;
+			_value[0] = v.x;
+			_value[1] = v.y;
+			_value[2] = v.z;
+			_value[3] = v.w;
+			_is_vec = true;
+		}
+
+		std::string to_str(unsigned int max_precision = 3) const;
+
+		// writes the text of to_str (at most VALUE_STR_SIZE characters) without allocating, returns its length
+		size_t to_chars(char* buffer, unsigned int max_precision = 3) const;
+
+	private:
+		bool _is_vec; // common
+		unsigned int _num_dims;
+		glm::dvec4 _value;
+
+	} value_vec_t;
+
+	typedef struct value_mat {
+
+		value_mat() {
+			_value = glm::dmat4(1.0);
+			_num_dims = 2;
+			_is_vec = false;
+		}
+
+		value_mat(glm::dmat4 m, unsigned int d = 2) {
+			_value = m;
+			_num_dims = d;
+			_is_vec = false;
+		}
+
+		unsigned int get_num_dims() const {
+			return _num_dims;
+		}
+
+		bool is_mat() const {
+			return !_is_vec;
+		}
+
+		glm::dmat2 to_mat2() const {
+			return glm::dmat2(
+				_value[0][0], _value[0][1],
+				_value[1][0], _value[1][1]);
+		}
+
+		glm::dmat3 to_mat3() const {
+			return glm::dmat3(
+				_value[0][0], _value[0][1], _value[0][2],
+				_value[1][0], _value[1][1], _value[1][2],
+				_value[2][0], _value[2][1], _value[2][2]);
+		}
+
+		const glm::dmat4& to_mat4() const {
+			return _value;
+		}
+
+		// 4 columns of 4 lanes, contiguous
+		const double* data() const {
+			return &_value[0][0];
+		}
+
+		double* data() {
+			return &_value[0][0];
+		}
+
+		void set_mat2(glm::dmat2 m) {
+			_num_dims = 2;
+			_value[0][0] = m[0][0]; _value[0][1] = m[0][1];
+			_value[1][0] = m[1][0]; _value[1][1] = m[0][0];
+			_is_vec = false;
+		}
+
+		void set_mat3(glm::dmat3 m) {
+			_num_dims = 3;
+			_value[0][0] = m[0][0]; _value[0][1] = m[0][1]; _value[0][2] = m[0][2];
+			_value[1][0] = m[1][0]; _value[1][1] = m[1][1]; _value[1][2] = m[1][2];
+			_value[2][0] = m[2][0]; _value[2][1] = m[2][1]; _value[2][2] = m[2][2];
+			_is_vec = false;
+		}
+
+		void set_mat4(glm::dmat4 m) {
+			_num_dims = 4;
+			_value[0][0] = m[0][0]; _value[0][1] = m[0][1]; _value[0][2] = m[0][2]; _value[0][3] = m[0][3];
+			_value[1][0] = m[1][0]; _value[1][1] = m[1][1]; _value[1][2] = m[1][2]; _value[1][3] = m[1][3];
+			_value[2][0] = m[2][0]; _value[2][1] = m[2][1]; _value[2][2] = m[2][2]; _value[2][3] = m[2][3];
+			_value[3][0] = m[3][0]; _value[3][1] = m[3][1]; _value[3][2] = m[3][2]; _value[3][3] = m[3][3];
+			_is_vec = false;
+		}
+
+		std::string to_str(unsigned int max_precision = 3) const;
+
+		// writes the text of to_str (at most VALUE_STR_SIZE characters) without allocating, returns its length
+		size_t to_chars(char* buffer, unsigned int max_precision = 3) const;
+
+	private:
+		bool _is_vec; // common 
+		unsigned int _num_dims;
+		glm::dmat4 _value;
+
+	} value_mat_t;
+
+	// Tagged union - both members start with the same tag ("_is_vec" and
+	// "_num_dims"), so the shape can be read through either of them. Only the
+	// active member is copied: scalars and vectors move 40 bytes, matrices 136.
+	// Scalar programs don't use it at all: their bindings and registers are
+	// plain doubles (Program::run of doubles, scalar batch columns).
+	typedef struct value {
+
+		value() {
+			new(&vec) value_vec_t();
+		}
+
+		explicit value(double scalar) {
+			new(&vec) value_vec_t(glm::dvec4(scalar), 1);
+		}
+
+		value(glm::dvec4 v, unsigned int d = 1) {
+			new(&vec) value_vec_t(v, d);
+		}
+
+		value(glm::dmat4 m, unsigned int d = 2) {
+			new(&mat) value_mat_t(m, d);
+		}
+
+		value(const value& other) {
+			if (other.is_mat())
+				new(&mat) value_mat_t(other.mat);
+			else
+				new(&vec) value_vec_t(other.vec);
+		}
+
+		value& operator=(const value& other) {
+			if (other.is_mat())
+				new(&mat) value_mat_t(other.mat);
+			else
+				new(&vec) value_vec_t(other.vec);
+
+			return *this;
+		}
+
+		bool is_mat() const {
+			return vec.is_mat();
+		}
+
+		bool is_scalar() const {
+			return !vec.is_mat() && vec.get_num_dims() == 1;
+		}
+
+		unsigned int get_num_components() const {
+			return is_mat() ? mat.get_num_dims() * mat.get_num_dims() : vec.get_num_dims();
+		}
+
+		union {
+			value_vec_t vec;
+			value_mat_t mat;
+		};
+	} value_t;
+
+	// Shape of a value known before evaluation, "num_dims" 0 means unknown.
+	// Guessed shapes (variables, parameters without declared shape) are only
+	// used for specialization - they are checked when the value is loaded and
+	// a mismatch falls back to generic operations instead of being an error.
+	typedef struct shape {
+
+		unsigned char num_dims;
+		bool is_mat;
+		bool is_guess;
+
+		static shape unknown() {
+			return { 0, false, false };
+		}
+
+		static shape scalar(bool is_guess = false) {
+			return { 1, false, is_guess };
+		}
+
+		static shape vector(unsigned int num_dims, bool is_guess = false) {
+			return { (unsigned char)num_dims, false, is_guess };
+		}
+
+		static shape matrix(unsigned int num_dims, bool is_guess = false) {
+			return { (unsigned char)num_dims, true, is_guess };
+		}
+
+		static shape of(const value_t& value, bool is_guess = false) {
+			return { (unsigned char)value.vec.get_num_dims(), value.is_mat(), is_guess };
+		}
+
+		bool is_known() const {
+			return num_dims != 0;
+		}
+
+		bool is_scalar() const {
+			return num_dims == 1 && !is_mat;
+		}
+
+		bool matches(const value_t& value) const {
+			return value.is_mat() == is_mat && value.vec.get_num_dims() == num_dims;
+		}
+
+	} shape_t;
+
+	typedef std::vector<value_t> Bindings;
+
+	class Program;
+	class NodeArena;
+
+	value_t operator *(const value_t& left, const value_t& right);
+
+	class BaseNode
+	{
+	public:
+		virtual value_t value(const Bindings& bindings) = 0;
+		virtual bool is_constant() const = 0; // value is known at compile time
+		virtual BaseNode* fold(NodeArena& arena) = 0; // collapse constant subtrees into NumNode
+		virtual unsigned int emit(Program& program) const = 0; // lower to bytecode, returns position of result
+		virtual unsigned int height() const { return 1; } // longest path to a leaf, fold and emit recurse this deep
+		virtual TokenType token() const = 0; // operator or function of the node, counted by metrics
+
+		value_t value()
+		{
+			return value(Bindings());
+		}
+	};
+
+	class NumNode : public BaseNode
+	{
+		value_t _value;
+	public:
+		NumNode(value_t value)
+		{
+			_value = value;
+		}
+		virtual value_t value(const Bindings& bindings)
+		{
+			return _value;
+		}
+		virtual bool is_constant() const
+		{
+			return true;
+		}
+		virtual TokenType token() const
+		{
+			return SCALAR;
+		}
+		virtual BaseNode* fold(NodeArena& arena)
+		{
+			return this;
+		}
+		virtual unsigned int emit(Program& program) const;
+	};
+
+	class ParamNode : public BaseNode
+	{
+		unsigned int _index;
+	public:
+		ParamNode(unsigned int index)
+		{
+			_index = index;
+		}
+		virtual value_t value(const Bindings& bindings);
+		virtual bool is_constant() const
+		{
+			return false;
+		}
+		virtual TokenType token() const
+		{
+			return VARIABLE_PARAMETER;
+		}
+		virtual BaseNode* fold(NodeArena& arena)
+		{
+			return this;
+		}
+		virtual unsigned int emit(Program& program) const;
+	};
+
+	class VarNode : public BaseNode
+	{
+		std::vector<value_t>* _slots;
+		unsigned int _index;
+	public:
+		VarNode(std::vector<value_t>* slots, unsigned int index)
+		{
+			_slots = slots;
+			_index = index;
+		}
+		virtual value_t value(const Bindings& bindings)
+		{
+			return (*_slots)[_index];
+		}
+		virtual bool is_constant() const
+		{
+			return false;
+		}
+		virtual TokenType token() const
+		{
+			return VARIABLE_REFERENCE;
+		}
+		virtual BaseNode* fold(NodeArena& arena)
+		{
+			return this;
+		}
+		virtual unsigned int emit(Program& program) const;
+	};
+
+	class AssignNode : public BaseNode
+	{
+		std::vector<value_t>* _slots;
+		unsigned int _index;
+		BaseNode* _expression;
+	public:
+		AssignNode(std::vector<value_t>* slots, unsigned int index, BaseNode* expression)
+		{
+			_slots = slots;
+			_index = index;
+			_expression = expression;
+		}
+		virtual value_t value(const Bindings& bindings)
+		{
+			value_t result = _expression->value(bindings);
+			(*_slots)[_index] = result;
+			return result;
+		}
+		virtual bool is_constant() const
+		{
+			return false;
+		}
+		virtual TokenType token() const
+		{
+			return VARIABLE_ASSIGN;
+		}
+		virtual unsigned int height() const
+		{
+			return _expression->height() + 1;
+		}
+		virtual BaseNode* fold(NodeArena& arena);
+		virtual unsigned int emit(Program& program) const;
+	};
+
+	class OperNode : public BaseNode
+	{
+		char oper;
+		BaseNode* left;
+		BaseNode* right;
+		bool constant; // known when built, asking the children would walk the whole subtree
+		unsigned int levels;
+	public:
+		OperNode(char oper, BaseNode* left, BaseNode* right)
+		{
+			this->oper = oper;
+			this->right = right;
+			this->left = left;
+			this->constant = left->is_constant() && right->is_constant();
+			this->levels = std::max(left->height(), right->height()) + 1;
+		}
+		virtual value_t value(const Bindings& bindings);
+		virtual bool is_constant() const
+		{
+			return constant;
+		}
+		virtual TokenType token() const
+		{
+			return TokenType(oper);
+		}
+		virtual unsigned int height() const
+		{
+			return levels;
+		}
+		virtual BaseNode* fold(NodeArena& arena);
+		virtual unsigned int emit(Program& program) const;
+	};
+
+	class FuncNode : public BaseNode
+	{
+		BaseNode* _expression1, * _expression2, * _expression3, * _expression4;
+		TokenType _func;
+		bool _constant;
+		unsigned int _height;
+
+	public:
+		FuncNode(TokenType func, BaseNode* expression1, BaseNode* expression2 = nullptr, BaseNode* expression3 = nullptr, BaseNode* expression4 = nullptr)
+		{
+			_func = func;
+			_expression1 = expression1;
+			_expression2 = expression2;
+			_expression3 = expression3;
+			_expression4 = expression4;
+			_constant = (_func != RAND_FN) && // new value on every evaluation
+				(_expression1 == nullptr || _expression1->is_constant()) &&
+				(_expression2 == nullptr || _expression2->is_constant()) &&
+				(_expression3 == nullptr || _expression3->is_constant()) &&
+				(_expression4 == nullptr || _expression4->is_constant());
+			_height = 0;
+
+			for (const BaseNode* expression : { _expression1, _expression2, _expression3, _expression4 })
+				if (expression != nullptr)
+					_height = std::max(_height, expression->height());
+
+			_height++;
+		}
+		virtual value_t value(const Bindings& bindings);
+		virtual bool is_constant() const
+		{
+			return _constant;
+		}
+		virtual TokenType token() const
+		{
+			return _func;
+		}
+		virtual unsigned int height() const
+		{
+			return _height;
+		}
+		virtual BaseNode* fold(NodeArena& arena);
+		virtual unsigned int emit(Program& program) const;
+	};
+
+}
+
+#endif // !TYPES_H